@@ -0,0 +1,100 @@
+#include "../include/memory.hpp"
+#include "../include/static_cache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Cache;
+
+// Последовательные query против query_batch с разным размером пакета, для
+// иерархии и для отдельного кэша. У кэша на 1 ГБ метаданные наборов (~300 МБ)
+// не помещаются в кэш процессора, и на нём видна предвыборка
+namespace {
+    constexpr size_t ACCESSES = 1 << 20;
+
+    struct Setup {
+        const char* name;
+        std::shared_ptr<Cache::Cache> (*make)();
+        uint64_t range;
+    };
+
+    std::shared_ptr<Cache::Cache> make_model2_l1() {
+        return make_cache(16 * 1024, 32, 4, 32, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::MRU);
+    }
+
+    std::shared_ptr<Cache::Cache> make_large() {
+        return make_cache(1ULL << 30, 64, 16, 48, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::LRU);
+    }
+
+    std::vector<InQuery> make_accesses(uint64_t range) {
+        std::mt19937_64 rng(42);
+        std::vector<InQuery> accesses(ACCESSES);
+        for (auto& access : accesses) {
+            access.operation = (rng() % 4 == 0) ? Operation::WRITE : Operation::READ;
+            access.address = rng() % range & ~uint64_t{63};
+            access.size = 4;
+        }
+        return accesses;
+    }
+
+    // Target - Cache или MemoryHierarchy; batch == 0 - по одному запросу через query
+    template <typename Target>
+    double measure(Target& target, const std::vector<InQuery>& accesses, size_t batch, size_t& hits) {
+        std::vector<OutQuery> results(batch ? batch : 1);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t first = 0; first < accesses.size(); first += batch ? batch : 1) {
+            if (batch == 0) {
+                hits += target.query(accesses[first]).hit;
+                continue;
+            }
+            size_t count = std::min(batch, accesses.size() - first);
+            target.query_batch(accesses.data() + first, count, results.data());
+            for (size_t i = 0; i < count; ++i) hits += results[i].hit;
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / accesses.size();
+    }
+
+    double run(const Setup& setup, bool hierarchy, const std::vector<InQuery>& accesses, size_t batch, size_t& hits) {
+        auto cache = setup.make();
+        if (!hierarchy) {
+            cache->set_data_mode(DataMode::TAGS_ONLY);
+            return measure(*cache, accesses, batch, hits);
+        }
+        std::vector<std::shared_ptr<Cache::Cache>> caches{cache};
+        MemoryHierarchy target(caches, std::make_shared<MemoryModel>(), TraceLevel::NONE, DataMode::TAGS_ONLY);
+        return measure(target, accesses, batch, hits);
+    }
+}
+
+int main() {
+    const Setup setups[] = {
+        {"l1_16kb", make_model2_l1, 64 * 1024},
+        {"l1_1gb", make_large, 1ULL << 36},
+    };
+
+    std::printf("setup,target,batch,query_ns,batch_ns,speedup\n");
+    for (const auto& setup : setups) {
+        auto accesses = make_accesses(setup.range);
+        for (bool hierarchy : {false, true}) {
+            const char* target = hierarchy ? "hierarchy" : "cache";
+            size_t single_hits = 0;
+            double single_ns = run(setup, hierarchy, accesses, 0, single_hits);
+
+            for (size_t batch : {1, 16, 256, 4096}) {
+                size_t batch_hits = 0;
+                double batch_ns = run(setup, hierarchy, accesses, batch, batch_hits);
+                if (batch_hits != single_hits) {
+                    std::fprintf(stderr, "hit count mismatch for %s %s at batch %zu\n", setup.name, target, batch);
+                    return 1;
+                }
+                std::printf("%s,%s,%zu,%.2f,%.2f,%.2f\n", setup.name, target, batch, single_ns, batch_ns,
+                            single_ns / batch_ns);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include "../include/memory.hpp"
+#include "../include/static_cache.hpp"
+#include "../include/workload.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Cache;
+
+// Скорость моделирования по конфигурациям: отдельные кэши разной геометрии со
+// всеми политиками вытеснения и иерархии model1/model2, на нагрузках с
+// преобладанием попаданий, промахов и записей. Обращения генерируются заранее,
+// замеряется только query_batch; из нескольких повторов берётся лучший.
+// Вывод - CSV или, с --json, массив JSON для сравнения между версиями
+namespace {
+    constexpr size_t BATCH = 256;
+    constexpr int REPEATS = 3;
+
+    struct Mix {
+        const char* name;
+        const char* workload;
+    };
+
+    // Рабочее множество 2 КБ помещается в любой кэш; 256 МБ - ни в какой
+    const Mix MIXES[] = {
+        {"hit", "seq:footprint=2K:reads=0.9"},
+        {"miss", "uniform:footprint=256M"},
+        {"write", "zipf:footprint=1M:alpha=0.8:reads=0.2"},
+    };
+
+    struct Geometry {
+        const char* name;
+        size_t size;
+        uint64_t block_size;
+        size_t associativity;
+    };
+
+    const Geometry GEOMETRIES[] = {
+        {"4kb_4way_64b", 4 * 1024, 64, 4},
+        {"32kb_8way_64b", 32 * 1024, 64, 8},
+        {"1mb_16way_64b", 1024 * 1024, 64, 16},
+        {"16kb_fa_64b", 16 * 1024, 64, 256},
+    };
+
+    struct Policy {
+        const char* name;
+        ReplacementPolicy policy;
+    };
+
+    const Policy POLICIES[] = {
+        {"lru", ReplacementPolicy::LRU},     {"mru", ReplacementPolicy::MRU},     {"random", ReplacementPolicy::RANDOM},
+        {"plru", ReplacementPolicy::PLRU},   {"nru", ReplacementPolicy::NRU},     {"srrip", ReplacementPolicy::SRRIP},
+        {"brrip", ReplacementPolicy::BRRIP},
+    };
+
+    struct Result {
+        std::string target;
+        std::string config;
+        std::string policy;
+        const char* mix;
+        size_t accesses;
+        double ns_per_access;
+        double hit_rate;
+    };
+
+    std::vector<InQuery> make_accesses(const Mix& mix, size_t count) {
+        WorkloadSpec spec = parse_workload_spec(mix.workload);
+        WorkloadGenerator generator(spec);
+        std::vector<InQuery> accesses(count);
+        for (auto& access : accesses) generator.next(access);
+        return accesses;
+    }
+
+    // Доля попаданий по счётчикам первого уровня: OutQuery::hit иерархии
+    // означает только, что запрос обслужен, в том числе нижним уровнем
+    double first_level_hit_rate(const Cache::Cache& cache) { return cache.get_stats().hit_rate(); }
+    double first_level_hit_rate(const MemoryHierarchy& hierarchy) { return hierarchy.get_level_stats(0).hit_rate(); }
+
+    // make() создаёт Cache или MemoryHierarchy, каждый повтор - на новом экземпляре
+    template <typename Make>
+    void measure(Make make, const std::vector<InQuery>& accesses, double& best_ns, double& hit_rate) {
+        std::vector<OutQuery> results(BATCH);
+        best_ns = 0;
+        for (int repeat = 0; repeat < REPEATS; ++repeat) {
+            auto target = make();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t first = 0; first < accesses.size(); first += BATCH) {
+                size_t count = std::min(BATCH, accesses.size() - first);
+                target->query_batch(accesses.data() + first, count, results.data());
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            double ns = elapsed.count() / accesses.size();
+            if (repeat == 0 || ns < best_ns) best_ns = ns;
+            hit_rate = first_level_hit_rate(*target);
+        }
+    }
+
+    std::shared_ptr<MemoryHierarchy> make_model1() {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return make_model1_hierarchy(memory);
+    }
+
+    std::shared_ptr<MemoryHierarchy> make_model2() {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return make_model2_hierarchy(memory);
+    }
+
+    void print_csv(const std::vector<Result>& results) {
+        std::printf("target,config,policy,mix,accesses,ns_per_access,accesses_per_sec,hit_rate\n");
+        for (const auto& r : results) {
+            std::printf("%s,%s,%s,%s,%zu,%.2f,%.0f,%.4f\n", r.target.c_str(), r.config.c_str(), r.policy.c_str(),
+                        r.mix, r.accesses, r.ns_per_access, 1e9 / r.ns_per_access, r.hit_rate);
+        }
+    }
+
+    void print_json(const std::vector<Result>& results) {
+        std::printf("[\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            std::printf("  {\"target\": \"%s\", \"config\": \"%s\", \"policy\": \"%s\", \"mix\": \"%s\", "
+                        "\"accesses\": %zu, \"ns_per_access\": %.2f, \"accesses_per_sec\": %.0f, \"hit_rate\": %.4f}%s\n",
+                        r.target.c_str(), r.config.c_str(), r.policy.c_str(), r.mix, r.accesses, r.ns_per_access,
+                        1e9 / r.ns_per_access, r.hit_rate, i + 1 < results.size() ? "," : "");
+        }
+        std::printf("]\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    size_t accesses_per_run = 1 << 20;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (std::strcmp(argv[i], "--accesses") == 0 && i + 1 < argc) {
+            accesses_per_run = std::stoul(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--json] [--accesses N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    for (const auto& mix : MIXES) {
+        auto accesses = make_accesses(mix, accesses_per_run);
+
+        for (const auto& geometry : GEOMETRIES) {
+            for (const auto& policy : POLICIES) {
+                Result result{"cache", geometry.name, policy.name, mix.name, accesses.size(), 0, 0};
+                measure([&] {
+                    auto cache = make_cache(geometry.size, geometry.block_size, geometry.associativity, 48,
+                                            WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, policy.policy);
+                    cache->set_data_mode(DataMode::TAGS_ONLY);
+                    return cache;
+                }, accesses, result.ns_per_access, result.hit_rate);
+                results.push_back(result);
+            }
+        }
+
+        Result model1{"hierarchy", "model1", "lru", mix.name, accesses.size(), 0, 0};
+        measure(make_model1, accesses, model1.ns_per_access, model1.hit_rate);
+        results.push_back(model1);
+
+        Result model2{"hierarchy", "model2", "mru+lru", mix.name, accesses.size(), 0, 0};
+        measure(make_model2, accesses, model2.ns_per_access, model2.hit_rate);
+        results.push_back(model2);
+    }
+
+    if (json) {
+        print_json(results);
+    } else {
+        print_csv(results);
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "../include/tag_match.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Cache;
+
+// Сравнение поиска тега в наборе: поэлементный проход (как std::find_if по valid && tag)
+// против маски совпадений, полученной векторными инструкциями
+namespace {
+    constexpr size_t SETS = 64; // теги всех наборов помещаются в L1d, измеряется само сравнение
+    constexpr size_t LOOKUPS = 1 << 22;
+
+    size_t find_scalar(const uint64_t* tags, const uint8_t* valid, size_t ways, uint64_t tag) {
+        for (size_t way = 0; way < ways; ++way) {
+            if (valid[way] && tags[way] == tag) return way;
+        }
+        return ways;
+    }
+
+    size_t find_masked(const uint64_t* tags, const uint8_t* valid, size_t ways, uint64_t tag) {
+        uint64_t mask = tag_match_mask(tags, ways, tag);
+        while (mask) {
+            size_t way = static_cast<size_t>(__builtin_ctzll(mask));
+            if (valid[way]) return way;
+            mask &= mask - 1;
+        }
+        return ways;
+    }
+
+    template <typename Find>
+    double measure(Find find, const std::vector<uint64_t>& tags, const std::vector<uint8_t>& valid,
+                   const std::vector<std::pair<size_t, uint64_t>>& lookups, size_t ways, size_t& checksum) {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& [set, tag] : lookups) {
+            checksum += find(tags.data() + set * ways, valid.data() + set * ways, ways, tag);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / lookups.size();
+    }
+}
+
+int main() {
+    std::mt19937_64 rng(42);
+    std::printf("isa=%s\n", tag_match_isa());
+    std::printf("ways,scalar_ns,simd_ns,speedup\n");
+
+    for (size_t ways : {4, 8, 16, 32}) {
+        std::vector<uint64_t> tags(SETS * ways);
+        std::vector<uint8_t> valid(SETS * ways, 1);
+        for (auto& tag : tags) tag = rng() >> 20;
+
+        // Половина обращений попадает в случайный путь, половина промахивается
+        std::vector<std::pair<size_t, uint64_t>> lookups(LOOKUPS);
+        for (auto& [set, tag] : lookups) {
+            set = rng() % SETS;
+            tag = (rng() & 1) ? tags[set * ways + rng() % ways] : (rng() >> 20) | (1ULL << 50);
+        }
+
+        size_t scalar_sum = 0;
+        size_t simd_sum = 0;
+        double scalar_ns = measure(find_scalar, tags, valid, lookups, ways, scalar_sum);
+        double simd_ns = measure(find_masked, tags, valid, lookups, ways, simd_sum);
+        if (scalar_sum != simd_sum) {
+            std::fprintf(stderr, "mismatch at %zu ways\n", ways);
+            return 1;
+        }
+        std::printf("%zu,%.2f,%.2f,%.2f\n", ways, scalar_ns, simd_ns, scalar_ns / simd_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace Cache {
+
+    // Текст копится в собственном буфере и уходит в поток кусками по capacity байт,
+    // без сброса потока на каждой строке; числа форматируются через to_chars
+    class BufferedWriter {
+    public:
+        static constexpr size_t CAPACITY = 64 * 1024;
+    private:
+        std::ostream& _out;
+        std::string _buffer;
+        size_t _capacity;
+
+        void spill() {
+            if (_buffer.size() >= _capacity) flush();
+        }
+    public:
+        explicit BufferedWriter(std::ostream& out, size_t capacity = CAPACITY) : _out(out), _capacity(capacity) {
+            _buffer.reserve(capacity + 256);
+        }
+        ~BufferedWriter() { flush(); }
+
+        BufferedWriter(const BufferedWriter&) = delete;
+        BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+        BufferedWriter& operator<<(std::string_view text) {
+            _buffer.append(text);
+            spill();
+            return *this;
+        }
+
+        BufferedWriter& operator<<(char c) {
+            _buffer.push_back(c);
+            spill();
+            return *this;
+        }
+
+        BufferedWriter& operator<<(int64_t value) {
+            char digits[24];
+            auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+            return *this << std::string_view(digits, end - digits);
+        }
+
+        BufferedWriter& operator<<(uint64_t value) {
+            char digits[24];
+            auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+            return *this << std::string_view(digits, end - digits);
+        }
+
+        BufferedWriter& operator<<(int value) { return *this << static_cast<int64_t>(value); }
+
+        // Шестнадцатеричное число без префикса, дополненное нулями слева до width цифр
+        BufferedWriter& hex(uint64_t value, size_t width = 0) {
+            char digits[16];
+            auto end = std::to_chars(digits, digits + sizeof(digits), value, 16).ptr;
+            size_t length = end - digits;
+            if (length < width) _buffer.append(width - length, '0');
+            return *this << std::string_view(digits, length);
+        }
+
+        void flush() {
+            if (_buffer.empty()) return;
+            _out.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+            _buffer.clear();
+        }
+    };
+
+}
@@ -1,16 +1,21 @@
 #pragma once
 
 #include <iostream>
-#include <list>
 #include <vector>
+#include <memory>
 #include <optional>
 #include <array> 
-#include <unordered_map>
+#include <cstdint>
 #include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <iomanip>
 
+#include "replacement.hpp"
+#include "static_vector.hpp"
+#include "stats.hpp"
+#include "tag_match.hpp"
+
 namespace Cache{
     enum class Operation { READ, WRITE};
     enum class WritePolicy {
@@ -24,10 +29,9 @@ namespace Cache{
         BOTH           
     };
 
-    enum class ReplacementPolicy {
-        LRU,  // Least Recently Used
-        MRU,  // Most Recently Used
-        RANDOM 
+    enum class DataMode {
+        FULL,      // блоки хранят данные, чтения возвращают значения
+        TAGS_ONLY  // только теги и состояние блоков: для подсчёта попаданий и вытеснений
     };
 
     class Data { 
@@ -96,34 +100,41 @@ namespace Cache{
         }
     };
 
-    struct CacheBlock {
-        size_t id;
-        bool valid = false;       
-        unsigned long int tag{};
-        bool dirty = false;
-        Data data;
-
-        CacheBlock(size_t block_id, bool v, uint64_t t, bool d, Data dt) 
-            : id(block_id), valid(v), tag(t), dirty(d), data(std::move(dt)) {
-            if (dt.valid_count > 0) {
-                data.valid_count = dt.valid_count;
-            } else {
-                data.valid_count = Data::SIZE;
-            }
-            if (dt.valid_count < Data::SIZE) {
-                std::fill(data.buffer.begin() + dt.valid_count, data.buffer.end(), 0);
-            }
+    // Данные блока при заведении: пустой буфер считается полностью заполненным нулями
+    inline Data make_block_data(const Data& dt) {
+        Data data = dt;
+        if (dt.valid_count > 0) {
+            data.valid_count = dt.valid_count;
+        } else {
+            data.valid_count = Data::SIZE;
         }
-        
-        CacheBlock(size_t block_id, uint64_t t, const Data& d) 
-            : id(block_id), tag(t), data(d), valid(true) {}
+        if (dt.valid_count < Data::SIZE) {
+            std::fill(data.buffer.begin() + dt.valid_count, data.buffer.end(), 0);
+        }
+        return data;
+    }
+
+    // Плоское хранилище тегов: набор index занимает ячейки [index * ways, (index + 1) * ways)
+    // во всех массивах, поэтому поиск по набору не выходит за пределы пары кэш-линий
+    struct TagStore {
+        size_t sets = 0;
+        size_t ways = 0;
+
+        std::vector<uint64_t> tags;        // у незанятых путей INVALID_TAG
+        std::vector<uint8_t> valid;
+        std::vector<uint8_t> dirty;
+        std::vector<unsigned int> count;   // для отслеживания ассоциативности, заняты первые count путей
+        std::vector<Data> data;
+
+        TagStore() = default;
+        TagStore(size_t num_sets, size_t num_ways)
+            : sets(num_sets), ways(num_ways),
+              tags(num_sets * num_ways, INVALID_TAG), valid(num_sets * num_ways, 0), dirty(num_sets * num_ways, 0),
+              count(num_sets, 0), data(num_sets * num_ways) {}
+
+        size_t slot(size_t index, size_t way) const { return index * ways + way; }
     };
 
-    struct CacheLine {
-        std::list<CacheBlock> cache_line;
-        unsigned int count{}; // для отслеживания ассоциативности
-    }; 
-
     struct InQuery {
         Operation operation;
         uint64_t address;
@@ -131,13 +142,30 @@ namespace Cache{
         size_t size = Data::SIZE;
     };
 
+    constexpr size_t MAX_OUT_REQUESTS = 3;
+    constexpr size_t BATCH_PREFETCH_DISTANCE = 8; // на сколько запросов вперёд query_batch подтягивает наборы
+    constexpr size_t BATCH_PREFETCH_MIN_BYTES = 1 << 20; // меньшие массивы тегов и так лежат в кэше процессора
+
     struct OutQuery {
         bool hit = false;
-        bool evicted = false; // если был вытеснен блок, сохраняем адрес и меняем флаг
-        int evicted_tag = -1;
-        std::vector<InQuery> out; // запросы, которые нужно передать дальше
+        bool evicted = false; // если был вытеснен блок, сохраняем его тег и меняем флаг
+        uint64_t evicted_tag = 0; // действителен только при evicted
+        size_t fill_way = static_cast<size_t>(-1); // путь, занятый при промахе с заведением блока
+        // Запросы, которые нужно передать дальше: не больше записи вытесненного блока
+        // и запроса на чтение/запись, поэтому хватает встроенного буфера
+        StaticVector<InQuery, MAX_OUT_REQUESTS> out;
         std::optional<Data> returned_data; // данные на чтение
 
+        // Дешевле присваивания OutQuery{}: не обнуляет встроенный буфер запросов
+        void reset() {
+            hit = false;
+            evicted = false;
+            evicted_tag = 0;
+            fill_way = static_cast<size_t>(-1);
+            out.clear();
+            returned_data.reset();
+        }
+
         const Data* get_data() const {
             if (returned_data.has_value()) return &returned_data.value();
             return nullptr;
@@ -148,6 +176,37 @@ namespace Cache{
         }  
     };
     
+    // Параметры кэша, известные только во время выполнения. StaticCache подставляет
+    // вместо них структуру с теми же полями в виде static constexpr
+    struct RuntimeConfig {
+        using Replacement = ReplacementState;
+
+        size_t associativity;
+        size_t offset_bits;
+        size_t index_bits;
+        WritePolicy write_policy;
+        AllocationPolicy alloc_policy;
+        ReplacementPolicy repl_policy;
+    };
+
+    // Разложение адреса на смещение в блоке, номер набора и тег
+    struct AddressLayout {
+        size_t offset_bits;
+        size_t index_bits;
+
+        uint64_t tag(uint64_t address) const {
+            return address >> (offset_bits + index_bits);
+        }
+
+        uint64_t index(uint64_t address) const {
+            return (address >> offset_bits) & ((1ULL << index_bits) - 1ULL);
+        }
+
+        uint64_t offset(uint64_t address) const {
+            return address & ((1ULL << offset_bits) - 1ULL);
+        }
+    };
+
     class Cache{
     private:
         size_t _size;
@@ -163,68 +222,132 @@ namespace Cache{
         size_t _offset_bits; // вспомогательные значения для адреса
         size_t _index_bits;  
         size_t _tag_bits;   
-        
-        size_t _next_block_id = 0;
 
-        std::unordered_map<size_t, CacheLine> _tag_store;
+        TagStore _tag_store;
+        std::unique_ptr<ReplacementState> _replacement;
+        std::unique_ptr<InsertionController> _insertion; // нет для InsertionPolicy::NORMAL
+        DataMode _data_mode = DataMode::FULL;
+        CacheStats _stats;
     public:
         Cache(size_t size, uint64_t block_size, size_t associativity, uint64_t address_bits, WritePolicy wp, AllocationPolicy ap, ReplacementPolicy rp) 
         : _size(size), _block_size(block_size), _associativity(associativity), _address_bits(address_bits),
           _write_policy(wp), _alloc_policy(ap), _repl_policy(rp),
           _num_lines(size / (block_size * associativity)),
-          _offset_bits(static_cast<size_t>(log2(block_size))),  _index_bits(static_cast<size_t>(log2(_num_lines))), _tag_bits(address_bits - _offset_bits - _index_bits){
-
-            _tag_store.clear();
-            CacheLine line;
-            for (size_t i = 0; i < _num_lines; ++i) {
-                
-                line.count = 0;
-                _tag_store[i] = line;
-            }
-        }
+          _offset_bits(static_cast<size_t>(log2(block_size))),  _index_bits(static_cast<size_t>(log2(_num_lines))), _tag_bits(address_bits - _offset_bits - _index_bits),
+          _tag_store(_num_lines, associativity),
+          _replacement(make_replacement(rp, _num_lines, associativity)),
+          _stats(_num_lines) {}
 
-        size_t generate_block_id() { return _next_block_id++; }
+        virtual ~Cache() = default;
 
-        auto query(InQuery const&) -> OutQuery;
+        virtual auto query(InQuery const&) -> OutQuery;
 
-        uint64_t get_tag(uint64_t address) const {
-            return address >> (_offset_bits + _index_bits);
-        }
+        // Пакет обрабатывается в порядке программы, results[i] - ответ на queries[i]
+        virtual void query_batch(const InQuery* queries, size_t count, OutQuery* results);
+
+        // Для ReplacementPolicy::OPT: номер следующего обращения к блоку очередного запроса
+        void set_next_use(uint64_t next) { _replacement->set_next_use(next); }
 
-        uint64_t get_index(uint64_t address) const {
-            return (address >> _offset_bits) & ((1ULL << _index_bits) - 1ULL);
+        // Заранее подтягивает метаданные набора, к которому относится address
+        void prefetch(uint64_t address) const;
+        bool prefetch_useful() const {
+            return _tag_store.tags.size() * sizeof(uint64_t) >= BATCH_PREFETCH_MIN_BYTES;
         }
 
-        uint64_t get_offset(uint64_t address) const {
-            return address & ((1ULL << _offset_bits) - 1ULL);
+        AddressLayout layout() const { return {_offset_bits, _index_bits}; }
+
+        uint64_t get_tag(uint64_t address) const { return layout().tag(address); }
+        uint64_t get_index(uint64_t address) const { return layout().index(address); }
+        uint64_t get_offset(uint64_t address) const { return layout().offset(address); }
+
+        // Адрес начала блока с тегом tag в наборе index
+        uint64_t block_address(uint64_t index, uint64_t tag) const {
+            return (tag << (_offset_bits + _index_bits)) | (index << _offset_bits);
         }
        
 
-        auto find_block(CacheLine& line, uint64_t tag) { // возвращaем нужный блок
-            return std::find_if(line.cache_line.begin(), line.cache_line.end(),
-                [tag](const CacheBlock& block) { 
-                    return block.valid && block.tag == tag; 
-                });
-        }
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        size_t find_block(size_t index, uint64_t tag) const; // возвращaем путь с нужным блоком или npos
 
         auto get_write_policy(){return _write_policy;}
-        std::unordered_map<size_t, CacheLine>& get_tag_store() { return _tag_store; }
+        TagStore& get_tag_store() { return _tag_store; }
         auto get_alloc_policy(){return _alloc_policy;}
+        DataMode get_data_mode() const { return _data_mode; }
+
+        // В режиме TAGS_ONLY массив данных освобождается, остаются только метаданные
+        void set_data_mode(DataMode mode) {
+            _data_mode = mode;
+            if (mode == DataMode::TAGS_ONLY) {
+                std::vector<Data>().swap(_tag_store.data);
+            } else {
+                _tag_store.data.assign(_tag_store.sets * _tag_store.ways, Data{});
+            }
+        }
+
+        void handle_write(size_t index, size_t way, const Data& data);
 
-        void handle_write(CacheBlock& block, const Data& data);
+        // Кладёт пришедший с нижнего уровня блок в путь, занятый при промахе
+        // (OutQuery::fill_way): без повторного поиска, признак dirty не меняется
+        void fill(uint64_t address, size_t way, const Data& block);
 
         bool should_allocate(Operation op) const;
-        auto select_victim(CacheLine& line) -> std::list<CacheBlock>::iterator;
+        size_t select_victim(size_t index);
 
-        void print_cache_state();
-    private:
-        // Метод для перемешения блока в начало списка
-        void move_beg_block(CacheLine& line, std::list<CacheBlock>::iterator block_it) {
-            if (block_it != line.cache_line.begin()) {
-                line.cache_line.splice(line.cache_line.begin(), line.cache_line, block_it);
+        // Одинаковый seed даёт одинаковые решения RANDOM, BRRIP и бимодальной вставки
+        void seed_replacement(uint64_t seed) {
+            _replacement->seed(seed);
+            if (_insertion) _insertion->seed(seed);
+        }
+
+        void set_insertion_policy(InsertionPolicy policy) {
+            if (policy == InsertionPolicy::NORMAL) {
+                _insertion.reset();
+            } else {
+                _insertion = std::make_unique<InsertionController>(policy, _num_lines);
             }
         }
+        InsertionPolicy get_insertion_policy() const {
+            return _insertion ? _insertion->policy() : InsertionPolicy::NORMAL;
+        }
+        const InsertionController* get_insertion_controller() const { return _insertion.get(); }
+
+        void print_cache_state(std::ostream& out = std::cout);
+
+        const CacheStats& get_stats() const { return _stats; }
+        void reset_stats() { _stats.reset(); }
+    protected:
+        RuntimeConfig runtime_config() const {
+            return {_associativity, _offset_bits, _index_bits, _write_policy, _alloc_policy, _repl_policy};
+        }
 
-        void add_block(CacheLine& line, uint64_t tag, Data data, OutQuery& result);
+        // Общая реализация для Cache и StaticCache, определена в cache_impl.hpp
+        template <typename Config>
+        void query_impl(const Config& cfg, InQuery const& query, OutQuery& result); // result приходит пустым
+        template <typename Config>
+        void query_batch_impl(const Config& cfg, const InQuery* queries, size_t count, OutQuery* results);
+        template <typename Config>
+        size_t find_block_impl(const Config& cfg, size_t index, uint64_t tag) const;
+        template <typename Config>
+        size_t select_victim_impl(const Config& cfg, size_t index);
+        template <typename Config>
+        void prefetch_set(const Config& cfg, size_t index) const;
+        template <typename Config>
+        typename Config::Replacement& replacement_of(const Config&) {
+            return static_cast<typename Config::Replacement&>(*_replacement);
+        }
+        template <typename Config>
+        const typename Config::Replacement& replacement_of(const Config&) const {
+            return static_cast<const typename Config::Replacement&>(*_replacement);
+        }
+        template <typename Config>
+        static bool should_allocate_impl(const Config& cfg, Operation op);
+        template <typename Config>
+        void fill_replacement(const Config& cfg, size_t index, size_t way);
+    private:
+        // Занимает следующий свободный путь набора
+        size_t claim_free_way(size_t index) {
+            return _tag_store.count[index]++;
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "cache.hpp"
+
+// Шаблонная часть Cache: подключается там, где она инстанцируется
+// для RuntimeConfig (cache.cpp) или StaticConfig (static_cache.hpp)
+namespace Cache {
+    template <typename Config>
+    inline uint64_t tag_of(const Config& cfg, uint64_t address) {
+        return address >> (cfg.offset_bits + cfg.index_bits);
+    }
+
+    template <typename Config>
+    inline uint64_t index_of(const Config& cfg, uint64_t address) {
+        return (address >> cfg.offset_bits) & ((1ULL << cfg.index_bits) - 1ULL);
+    }
+
+    template <typename Config>
+    inline uint64_t offset_of(const Config& cfg, uint64_t address) {
+        return address & ((1ULL << cfg.offset_bits) - 1ULL);
+    }
+
+    template <typename Config>
+    inline size_t slot_of(const Config& cfg, size_t index, size_t way) {
+        return index * cfg.associativity + way;
+    }
+
+    template <typename Config>
+    size_t Cache::find_block_impl(const Config& cfg, size_t index, uint64_t tag) const {
+        const size_t base = index * cfg.associativity;
+        const uint64_t* tags = _tag_store.tags.data() + base;
+
+        // Для малой ассоциативности вызов через указатель дороже самого сравнения
+        if (cfg.associativity < 4) {
+            for (size_t way = 0; way < cfg.associativity; ++way) {
+                if (tags[way] == tag && _tag_store.valid[base + way]) {
+                    return way;
+                }
+            }
+            return npos;
+        }
+
+        for (size_t first = 0; first < cfg.associativity; first += TAG_MATCH_CHUNK) {
+            size_t ways = std::min(TAG_MATCH_CHUNK, cfg.associativity - first);
+            uint64_t mask = tag_match_mask(tags + first, ways, tag);
+            while (mask) {
+                size_t way = first + static_cast<size_t>(__builtin_ctzll(mask));
+                if (_tag_store.valid[base + way]) {
+                    return way;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return npos;
+    }
+
+    template <typename Config>
+    bool Cache::should_allocate_impl(const Config& cfg, Operation op) {
+        switch (cfg.alloc_policy) {
+            case AllocationPolicy::READ_ALLOCATE: 
+                return op == Operation::READ;
+            case AllocationPolicy::WRITE_ALLOCATE:
+                return op == Operation::WRITE;
+            case AllocationPolicy::BOTH:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    template <typename Config>
+    size_t Cache::select_victim_impl(const Config& cfg, size_t index) {
+        return replacement_of(cfg).victim(index);
+    }
+
+    template <typename Config>
+    void Cache::fill_replacement(const Config& cfg, size_t index, size_t way) {
+        if (_insertion && _insertion->insert_distant(index)) {
+            replacement_of(cfg).on_fill_distant(index, way);
+        } else {
+            replacement_of(cfg).on_fill(index, way);
+        }
+    }
+
+    template <typename Config>
+    void Cache::prefetch_set(const Config& cfg, size_t index) const {
+        size_t base = index * cfg.associativity;
+        __builtin_prefetch(_tag_store.tags.data() + base);
+        __builtin_prefetch(_tag_store.valid.data() + base);
+        __builtin_prefetch(_tag_store.dirty.data() + base);
+        __builtin_prefetch(_tag_store.count.data() + index);
+        replacement_of(cfg).prefetch(index);
+    }
+
+    template <typename Config>
+    void Cache::query_batch_impl(const Config& cfg, const InQuery* queries, size_t count, OutQuery* results) {
+        const bool prefetch = prefetch_useful();
+        for (size_t i = 0; i < count; ++i) {
+            if (prefetch && i + BATCH_PREFETCH_DISTANCE < count) {
+                prefetch_set(cfg, index_of(cfg, queries[i + BATCH_PREFETCH_DISTANCE].address));
+            }
+            results[i].reset();
+            query_impl(cfg, queries[i], results[i]);
+        }
+    }
+
+    template <typename Config>
+    inline size_t block_bytes_of(const Config& cfg) {
+        // Data хранит не больше Data::SIZE элементов, более длинный блок обрезается
+        return std::min(size_t{1} << cfg.offset_bits, Data::SIZE * sizeof(int));
+    }
+
+    template <typename Config>
+    void Cache::query_impl(const Config& cfg, InQuery const& query, OutQuery& result) {
+        size_t size_bytes = query.size;
+        size_t elements = (size_bytes + sizeof(int) - 1) / sizeof(int);
+        elements = std::min(elements, Data::SIZE);
+
+        uint64_t tag = tag_of(cfg, query.address);
+        uint64_t index = index_of(cfg, query.address);
+        size_t offset = std::min(offset_of(cfg, query.address) / sizeof(int), Data::SIZE); // номер элемента в блоке
+        const bool track_data = _data_mode == DataMode::FULL;
+
+        size_t way = find_block_impl(cfg, index, tag);
+        if (_insertion) {
+            _insertion->on_access(index, way != npos);
+        }
+
+        const bool is_read = query.operation == Operation::READ;
+        ++(is_read ? _stats.reads : _stats.writes);
+        ++_stats.set_accesses[index];
+
+        if (way != npos) { // Cache hit
+            result.hit = true;
+            ++(is_read ? _stats.read_hits : _stats.write_hits);
+            size_t slot = slot_of(cfg, index, way);
+            
+            replacement_of(cfg).on_hit(index, way);
+
+            if (!track_data) {
+                if (query.operation == Operation::WRITE) {
+                    _tag_store.dirty[slot] = (cfg.write_policy == WritePolicy::WRITE_BACK);
+                    if (cfg.write_policy == WritePolicy::WRITE_THROUGH) {
+                        result.out.emplace_back(InQuery{Operation::WRITE, query.address, {}, query.size});
+                        ++_stats.write_throughs;
+                        _tag_store.dirty[slot] = false;
+                    }
+                }
+            } else if (query.operation == Operation::READ) {
+                const Data& block_data = _tag_store.data[slot];
+                Data response;
+                size_t elements_to_read = std::min(elements, Data::SIZE - offset);
+                block_data.read_data(response.buffer.data(), elements_to_read, offset);
+                response.valid_count = elements_to_read;
+                result.returned_data = response;
+            } else { // WRITE
+                Data& block_data = _tag_store.data[slot];
+                size_t elements_to_write = std::min(elements, Data::SIZE - offset);
+                block_data.write_data(query.data.buffer.data(), elements_to_write, offset);
+                _tag_store.dirty[slot] = (cfg.write_policy == WritePolicy::WRITE_BACK);
+                
+                if (cfg.write_policy == WritePolicy::WRITE_THROUGH) {
+                    ++_stats.write_throughs;
+                    result.out.emplace_back(InQuery{
+                        Operation::WRITE,
+                        query.address,
+                        query.data,
+                        query.size
+                    });
+                    _tag_store.dirty[slot] = false;
+                }
+            }
+        } else { // Cache miss
+            ++_stats.set_misses[index];
+            if (should_allocate_impl(cfg, query.operation)) {
+                ++_stats.fills;
+                // Один поиск на промах: путь выбирается здесь, данные блока
+                // для чтения потом кладёт fill в этот же путь
+                size_t fill_way;
+                if (_tag_store.count[index] >= cfg.associativity) {
+                    fill_way = select_victim_impl(cfg, index);
+                    size_t slot = slot_of(cfg, index, fill_way);
+                    result.evicted = true;
+                    result.evicted_tag = _tag_store.tags[slot];
+                    ++_stats.evictions;
+                    
+                    if (_tag_store.dirty[slot] && cfg.write_policy == WritePolicy::WRITE_BACK) {
+                        ++_stats.dirty_writebacks;
+                        uint64_t evicted_addr = (_tag_store.tags[slot] << (cfg.offset_bits + cfg.index_bits)) | 
+                                                (index << cfg.offset_bits);
+                        result.out.emplace_back(InQuery{
+                            Operation::WRITE,
+                            evicted_addr,
+                            track_data ? _tag_store.data[slot] : Data{},
+                            block_bytes_of(cfg)
+                        });
+                    }
+                } else {
+                    fill_way = claim_free_way(index);
+                }
+
+                size_t slot = slot_of(cfg, index, fill_way);
+                _tag_store.tags[slot] = tag;
+                _tag_store.valid[slot] = true;
+                _tag_store.dirty[slot] = (query.operation == Operation::WRITE) && 
+                                         (cfg.write_policy == WritePolicy::WRITE_BACK);
+                if (track_data) {
+                    // До подкачки блока (fill) остальные элементы - нули
+                    Data block;
+                    if (query.operation == Operation::WRITE) {
+                        block.write_data(query.data.buffer.data(), std::min(elements, Data::SIZE - offset), offset);
+                    }
+                    block.valid_count = block_bytes_of(cfg) / sizeof(int);
+                    _tag_store.data[slot] = block;
+                }
+                fill_replacement(cfg, index, fill_way);
+                result.fill_way = fill_way;
+
+                // Блок запрашиваем целиком, с его начала: для чтения и для записи
+                // не всего блока - записанные элементы ложатся поверх пришедших
+                bool whole_block = query.operation == Operation::WRITE && offset == 0 &&
+                                   elements * sizeof(int) >= block_bytes_of(cfg);
+                if (!whole_block) {
+                    result.out.emplace_back(InQuery{
+                        Operation::READ,
+                        query.address & ~((uint64_t{1} << cfg.offset_bits) - 1),
+                        {},
+                        block_bytes_of(cfg)
+                    });
+                }
+
+                // Для WRITE_THROUGH при записи сразу отправляем в память
+                if (query.operation == Operation::WRITE && 
+                    cfg.write_policy == WritePolicy::WRITE_THROUGH) {
+                    ++_stats.write_throughs;
+                    result.out.emplace_back(InQuery{
+                        Operation::WRITE,
+                        query.address,
+                        track_data ? query.data : Data{},
+                        query.size
+                    });
+                    _tag_store.dirty[slot] = false;
+                }
+            } else {
+                ++_stats.bypasses;
+                //Прямая запись в память
+                if (query.operation == Operation::WRITE) {
+                    result.out.push_back(query);
+                } else {
+                    result.out.emplace_back(InQuery{
+                        Operation::READ,
+                        query.address,
+                        {},
+                        Data::SIZE
+                    });
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "cache.hpp"
+#include "spsc_ring.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Уровень трассировки, собираемый в программу: 0 - без трассировки, 1 - обращения
+// к уровням кэша, 2 - ещё и обращения к памяти. Задаётся CMake-переменной
+// CACHE_TRACE_LEVEL; при 0 код трассировки не попадает в горячий путь вовсе
+#ifndef CACHE_TRACE_LEVEL
+#define CACHE_TRACE_LEVEL 2
+#endif
+
+namespace Cache {
+
+    enum class TraceLevel {
+        NONE,
+        BASIC,
+        FULL
+    };
+
+    constexpr TraceLevel COMPILED_TRACE_LEVEL = static_cast<TraceLevel>(CACHE_TRACE_LEVEL);
+
+    // Уровень, запрошенный во время выполнения, не выше собранного
+    inline TraceLevel compiled_trace_level(TraceLevel requested) {
+        return requested < COMPILED_TRACE_LEVEL ? requested : COMPILED_TRACE_LEVEL;
+    }
+
+    // Событие двоичной трассы: обращение к уровню кэша или к памяти. Данные не
+    // сохраняются, только то, что нужно для строки трассы без data=[...]
+    struct TraceEvent {
+        static constexpr uint8_t MEMORY_LEVEL = 0xff;
+        static constexpr uint8_t HIT = 1;
+        static constexpr uint8_t EVICTED = 2;
+
+        uint64_t sequence;    // номер запроса к иерархии в потоке; общий у всех событий запроса
+        uint64_t address;
+        uint64_t evicted_tag; // OutQuery::evicted_tag, при флаге EVICTED
+        uint32_t size;
+        uint8_t level;        // уровень кэша или MEMORY_LEVEL
+        uint8_t operation;    // Operation
+        uint8_t flags;
+        uint8_t reserved;
+    };
+    static_assert(sizeof(TraceEvent) == 32, "TraceEvent is written to the file as is");
+
+    // Двоичная трасса событий. Каждый поток пишет в свой блок без блокировок и атомиков;
+    // заполненный блок публикуется в кольцо SPSC этого потока, а поток записи
+    // забирает блоки из всех колец и пишет их в файл. Если кольцо заполнено,
+    // записывающий поток ждёт свободного слота - события не теряются.
+    //
+    // Файл: заголовок FILE_MAGIC, версия, размер события; затем блоки -
+    // номер потока, число событий и сами события. Порядок событий внутри потока сохраняется.
+    // close (и деструктор) вызываются после того, как потоки перестали записывать
+    class EventLog {
+    public:
+        static constexpr size_t BLOCK_EVENTS = 4096;
+        static constexpr size_t BLOCK_SLOTS = 8;
+        static constexpr char FILE_MAGIC[8] = {'C', 'A', 'C', 'H', 'E', 'E', 'V', 'T'};
+        static constexpr uint32_t FILE_VERSION = 2; // 2 - 64-битный evicted_tag
+    private:
+        struct Block {
+            std::array<TraceEvent, BLOCK_EVENTS> events;
+            uint32_t count = 0;
+        };
+        using BlockRing = SpscRing<Block, BLOCK_SLOTS>;
+
+        struct Producer {
+            BlockRing ring;
+            Block* block = nullptr;
+            std::thread::id owner;
+            uint32_t thread = 0;
+            uint64_t sequence = 0;
+
+            void publish() {
+                ring.commit();
+                block = &ring.acquire();
+                block->count = 0;
+            }
+        };
+
+        struct Local {
+            uint64_t log = 0; // id журнала, к которому относится producer
+            Producer* producer = nullptr;
+        };
+        static thread_local Local _local;
+
+        uint64_t _id;
+        std::ofstream _file;
+        std::mutex _producers_mutex;                     // только для регистрации потоков
+        std::vector<std::unique_ptr<Producer>> _producers;
+        std::atomic<size_t> _published_producers{0};
+        std::atomic<bool> _closing{false};
+        std::thread _writer;
+        bool _closed = false;
+
+        Producer& attach();
+        void write_blocks();
+
+        Producer& local() {
+            if (_local.log != _id) attach();
+            return *_local.producer;
+        }
+    public:
+        explicit EventLog(const std::string& path);
+        ~EventLog();
+
+        EventLog(const EventLog&) = delete;
+        EventLog& operator=(const EventLog&) = delete;
+
+        // Начало очередного запроса к иерархии в текущем потоке
+        void next_request() { ++local().sequence; }
+
+        void record(uint8_t level, Operation operation, uint64_t address, size_t size,
+                    bool hit, bool evicted, uint64_t evicted_tag) {
+            Producer& producer = local();
+            TraceEvent& event = producer.block->events[producer.block->count++];
+            event.sequence = producer.sequence;
+            event.address = address;
+            event.evicted_tag = evicted ? evicted_tag : 0;
+            event.size = static_cast<uint32_t>(size);
+            event.level = level;
+            event.operation = static_cast<uint8_t>(operation);
+            event.flags = (hit ? TraceEvent::HIT : 0) | (evicted ? TraceEvent::EVICTED : 0);
+            event.reserved = 0;
+            if (producer.block->count == BLOCK_EVENTS) producer.publish();
+        }
+
+        // Отдаёт неполные блоки всех потоков, дожидается записи и закрывает файл
+        void close();
+    };
+
+    // Последовательное чтение файла EventLog; ошибка формата - std::runtime_error
+    class EventLogReader {
+    private:
+        std::ifstream _in;
+        std::vector<TraceEvent> _block;
+        size_t _next = 0;
+        uint32_t _thread = 0;
+    public:
+        explicit EventLogReader(const std::string& path);
+
+        // false - конец файла
+        bool next(uint32_t& thread, TraceEvent& event);
+    };
+
+    class ReportSink;
+
+    // Событие в виде строки трассы (--trace level): BASIC - только обращения к
+    // уровням кэша, FULL - с вытесненными тегами и обращениями к памяти
+    void report_event(ReportSink& report, const TraceEvent& event, TraceLevel level);
+
+}
@@ -1,17 +1,24 @@
 #pragma once
 
 #include "cache.hpp"
+#include "event_trace.hpp"
+#include "page_table.hpp"
+#include "report.hpp"
+#include "trace.hpp"
+#include "trace_import.hpp"
+#include "workload.hpp"
 #include <memory>
 #include <sstream>
-#include <unordered_set>
+#include <unordered_map>
 #include <boost/program_options.hpp>
 
 namespace Cache {
 
-    enum class TraceLevel {
-        NONE,
-        BASIC,
-        FULL
+    // Как run_tests читает трассу: в том же потоке, что и моделирование, или
+    // конвейером из трёх потоков (разбор, моделирование, вывод)
+    enum class TraceIngestion {
+        SERIAL,
+        PIPELINED
     };
 
     enum class MemoryInitMode {
@@ -19,50 +26,108 @@ namespace Cache {
         ADDRESSES
     };
 
+    // Файл образа памяти (снимок кучи, сегмент core-файла) и адрес, с которого он лежит
+    struct MemoryImageSpec {
+        std::string path;
+        uint64_t base;
+    };
+
+    // "path@base", base - десятичный или 0x...; ошибка - std::invalid_argument
+    MemoryImageSpec parse_memory_image(std::string_view text);
+
+    // Память из 4 KB страниц (PageTable): страница заводится при первой записи.
+    // Незаписанные страницы виртуальные - их содержимое вычисляется по режиму
+    // инициализации (нули или адреса слов), поэтому чтение по любому адресу
+    // возвращает данные, а память растёт только с числом записанных страниц.
+    // Поверх страниц могут лежать образы (map_image): файл отображается с
+    // MAP_PRIVATE, блоки подгружаются по обращению, записи в файл не попадают
     class MemoryModel {
+    public:
+        static constexpr uint64_t BLOCK_BYTES = Data::SIZE * sizeof(int);
     private:
-        std::unordered_map<uint64_t, Data> _memory;
+        static_assert(PAGE_SIZE / BLOCK_BYTES == PAGE_BLOCKS, "one mask bit per memory block");
+
+        struct Image {
+            uint64_t base;
+            uint64_t end;                         // конец, округлённый до страницы
+            std::string path;
+            std::unique_ptr<MappedFile> file;
+            std::vector<uint64_t> written_blocks; // маски блоков по страницам, как в Page
+            std::vector<uint64_t> changed_blocks;
+            size_t dirty_count = 0;               // страниц с записями
+        };
+
+        PageTable _pages;
+        std::vector<Image> _images;         // по возрастанию base
+        MemoryInitMode _init_mode = MemoryInitMode::ZEROS;
         TraceLevel _trace_level;
+        DataMode _data_mode = DataMode::FULL;
+        MemoryStats _stats;
+        std::shared_ptr<ReportSink> _report = standard_report();
+        std::shared_ptr<EventLog> _events;
+
+        std::vector<uint64_t> _changed_pages; // страницы с ненулевой changed_blocks, без повторов
 
-        std::unordered_set<uint64_t> _modified_addresses; // Dля отслеживания измененных адресов
+        // Значение слова незаписанной памяти
+        int virtual_word(uint64_t address) const {
+            return _init_mode == MemoryInitMode::ADDRESSES ? static_cast<int>(address) : 0;
+        }
+        Page& materialize(uint64_t address);
+        const Image* find_image(uint64_t address) const;
+        // Слова блока в образе или записанной странице; nullptr - блок виртуальный
+        const int* find_block(uint64_t aligned_addr) const;
+        // Слова блока для записи: страница заводится, блок помечается изменённым
+        int* writable_block(uint64_t aligned_addr);
+        // Маски страницы с записями: в PageTable или в образе; nullptr - записей не было
+        uint64_t* block_masks(uint64_t number, bool changed);
+        void read_block(uint64_t aligned_addr, Data& block) const;
+        // Блоки страницы number из mask по возрастанию адреса
+        void print_blocks(uint64_t number, uint64_t mask) const;
 
     public:
         MemoryModel() : _trace_level(TraceLevel::NONE) {}  
-        MemoryModel(TraceLevel trace) : _trace_level(trace) {}  
+        MemoryModel(TraceLevel trace) : _trace_level(compiled_trace_level(trace)) {}  
         OutQuery query(const InQuery& in);
+        // Записанные страницы сбрасываются; образы остаются
         void initialize(MemoryInitMode mode);
+        // base кратен 4 KB, образы не пересекаются; ошибка - исключение
+        void map_image(const std::string& path, uint64_t base);
+        // По строке на образ: размер и число изменённых страниц
+        void print_images() const;
         void print_memory();
         void set_trace_level(TraceLevel level);
 
-        void mark_modified(uint64_t address) {
-            _modified_addresses.insert(address);
-        }
-
-        void print_modified_memory() {
-            if (_modified_addresses.empty()) {
-                return;
-            }
-
-            std::cout << "\nModified Memory Contents\n"  
-                    << "Address | Data" << std::endl;
-
-            for (const auto& address : _modified_addresses) {
-                if (_memory.count(address)) {
-                    const auto& data = _memory[address];
-                    std::cout << "0x" << std::hex << std::setw(8) << std::setfill('0') << address << " | ";
-
-                    if (data.valid_count == 0) {
-                        std::cout << "<empty>";
-                    } else {
-                        for (size_t i = 0; i < data.valid_count; ++i) {
-                            std::cout << std::dec << data[i];
-                            if (i < data.valid_count - 1) std::cout << ", ";
-                        }
-                    }
-                    std::cout << std::endl;
+        // Куда идут события памяти и всей иерархии, построенной на этой памяти
+        void set_report(std::shared_ptr<ReportSink> report) { _report = std::move(report); }
+        ReportSink& report() const { return *_report; }
+
+        // Двоичная трасса событий памяти и иерархии; nullptr - не ведётся
+        void set_event_log(std::shared_ptr<EventLog> events) { _events = std::move(events); }
+        EventLog* events() const { return _events.get(); }
+
+        const MemoryStats& get_stats() const { return _stats; }
+        void reset_stats() { _stats.reset(); }
+        size_t allocated_pages() const { return _pages.pages(); }
+
+        // В режиме TAGS_ONLY память ничего не хранит и отвечает на любое чтение
+        void set_data_mode(DataMode mode) {
+            _data_mode = mode;
+            if (mode == DataMode::TAGS_ONLY) {
+                initialize(_init_mode);
+                for (auto& image : _images) {
+                    std::fill(image.written_blocks.begin(), image.written_blocks.end(), 0);
+                    std::fill(image.changed_blocks.begin(), image.changed_blocks.end(), 0);
+                    image.dirty_count = 0;
                 }
+                _changed_pages.clear();
             }
         }
+
+        // Все блоки, в которые писали, по возрастанию адреса
+        void print_modified_memory();
+        // Только блоки, изменённые после предыдущего вызова, по возрастанию адреса;
+        // время - по числу изменённых страниц, а не по всей записанной памяти
+        void print_memory_changes();
     };
 
     class MemoryHierarchy {
@@ -71,7 +136,11 @@ namespace Cache {
         std::shared_ptr<MemoryModel> _memory;
 
         TraceLevel _trace_level;
+        DataMode _data_mode;
         void log_query(size_t level, const InQuery& query, const OutQuery& result);
+        void query_into(const InQuery& query, OutQuery& final_result); // final_result приходит пустым
+        // Запрос к уровню level; level == levels() - к памяти
+        void resolve(size_t level, const InQuery& query, OutQuery& result);
 
         void update_cache_level(size_t level, uint64_t address, const Data& data);
         void update_all_levels(size_t highest_level, uint64_t address, const Data& data);
@@ -79,24 +148,68 @@ namespace Cache {
     public:
         MemoryHierarchy(std::vector<std::shared_ptr<Cache>> cache_levels,
                     std::shared_ptr<MemoryModel> mem,
-                    TraceLevel trace = TraceLevel::NONE)
-            : _caches(std::move(cache_levels)), _memory(std::move(mem)), _trace_level(trace) {}
+                    TraceLevel trace = TraceLevel::NONE,
+                    DataMode data_mode = DataMode::FULL)
+            : _caches(std::move(cache_levels)), _memory(std::move(mem)), _trace_level(compiled_trace_level(trace)),
+              _data_mode(data_mode) {
+            for (auto& cache : _caches) {
+                cache->set_data_mode(data_mode);
+            }
+            _memory->set_data_mode(data_mode);
+        }
 
+        // hit - запрос обслужен: попадание или чтение, обслуженное нижним уровнем.
+        // Попадания и промахи каждого уровня - в get_level_stats
         OutQuery query(const InQuery& query);
 
+        // Результат совпадает с последовательными вызовами query: следующие уровни
+        // зависят от предыдущих запросов, поэтому наборы L1 подтягиваются заранее
+        void query_batch(const InQuery* queries, size_t count, OutQuery* results);
+
         void add_cache_level(Cache cache);
+        // Состояние кэшей и записанная память; вывод сбрасывается в поток
         void print_caches_state();
 
         void print_changes() {
-            _memory->print_modified_memory();
+            _memory->print_memory_changes();
         }
 
+        // Вывод иерархии - вывод её памяти
+        ReportSink& report() const { return _memory->report(); }
+
+        // Сводка счётчиков всех уровней и памяти; per_set - с разбивкой по наборам
+        // (только в текстовом виде). Вывод сбрасывается в поток
+        void print_stats(bool per_set = false);
+        void reset_stats();
+
+        size_t levels() const { return _caches.size(); }
+        const CacheStats& get_level_stats(size_t level) const { return _caches[level]->get_stats(); }
+        const MemoryStats& get_memory_stats() const { return _memory->get_stats(); }
+
     private:
 
     };
 
+// Иерархии программ model1 (один кэш 4 KB) и model2 (L1 16 KB и L2 256 B).
+// Тесты и бенчмарки строят их здесь же, чтобы проверять ту же конфигурацию
+std::shared_ptr<MemoryHierarchy> make_model1_hierarchy(std::shared_ptr<MemoryModel> memory,
+                                                       TraceLevel trace = TraceLevel::NONE,
+                                                       DataMode data_mode = DataMode::FULL,
+                                                       InsertionPolicy insertion = InsertionPolicy::NORMAL);
+std::shared_ptr<MemoryHierarchy> make_model2_hierarchy(std::shared_ptr<MemoryModel> memory,
+                                                       TraceLevel trace = TraceLevel::NONE,
+                                                       DataMode data_mode = DataMode::FULL,
+                                                       InsertionPolicy insertion = InsertionPolicy::NORMAL);
+
 void process_commands(std::shared_ptr<MemoryHierarchy> hierarchy);
-void run_tests(const std::string& test_file, std::shared_ptr<MemoryHierarchy> hierarchy);
+void run_tests(const std::string& test_file, std::shared_ptr<MemoryHierarchy> hierarchy,
+               TraceIngestion ingestion = TraceIngestion::SERIAL,
+               TraceFormat format = TraceFormat::NATIVE);
+
+// Одна запись текстовой трассы так, как её исполняет run_tests: эхо строки,
+// обращение или show/stats, затем вывод изменений. Вывод остаётся в буфере
+// hierarchy.report() до сброса
+void run_text_record(MemoryHierarchy& hierarchy, TraceCommand command, const InQuery& query, std::string_view line);
 
 boost::program_options::options_description create_options_description();
 boost::program_options::variables_map parse_command_line_args(
@@ -106,5 +219,15 @@ bool handle_help_option(const boost::program_options::variables_map& vm,
                        const boost::program_options::options_description& desc);
 TraceLevel get_trace_level(const boost::program_options::variables_map& vm);
 MemoryInitMode get_memory_init_mode(const boost::program_options::variables_map& vm);
+DataMode get_data_mode(const boost::program_options::variables_map& vm);
+InsertionPolicy get_insertion_policy(const boost::program_options::variables_map& vm);
+TraceIngestion get_trace_ingestion(const boost::program_options::variables_map& vm);
+TraceFormat get_trace_format(const boost::program_options::variables_map& vm);
+OutputFormat get_output_format(const boost::program_options::variables_map& vm);
+WorkloadSpec get_workload_spec(const boost::program_options::variables_map& vm);
+// Отображает образы --image в memory; ошибка - сообщение и выход с кодом 1
+void map_memory_images(MemoryModel& memory, const boost::program_options::variables_map& vm);
+// Журнал --event-trace или nullptr
+std::shared_ptr<EventLog> get_event_log(const boost::program_options::variables_map& vm);
 
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "sweep.hpp"
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace Cache {
+
+    // Номера следующих обращений к тому же блоку для каждого обращения трассы
+    // (OptPolicy::NEVER - обращений больше нет). Первый проход пишет номера блоков
+    // во временный файл, второй идёт по файлу кусками с конца и заменяет их
+    // номерами следующих обращений. В памяти - кусок и последнее обращение к
+    // каждому блоку, поэтому трасса может быть больше оперативной памяти
+    class NextUseTable {
+    public:
+        static constexpr size_t DEFAULT_CHUNK = 1 << 20; // обращений в куске
+    private:
+        struct FileCloser {
+            void operator()(std::FILE* file) const { std::fclose(file); }
+        };
+
+        std::unique_ptr<std::FILE, FileCloser> _file;
+        uint64_t _size = 0;
+        std::vector<uint64_t> _chunk;
+        size_t _chunk_pos = 0;
+        size_t _chunk_fill = 0;
+        uint64_t _read = 0; // прочитано из файла при последовательном чтении
+
+        void read_at(uint64_t first, size_t count);
+        void write_at(uint64_t first, size_t count);
+    public:
+        NextUseTable(AccessReader& reader, uint64_t block_size, size_t chunk = DEFAULT_CHUNK);
+
+        uint64_t size() const { return _size; }
+
+        // Последовательное чтение таблицы с начала
+        void rewind();
+        uint64_t next();
+    };
+
+    struct OptConfig {
+        size_t size;
+        uint64_t block_size;
+        size_t associativity;
+        WritePolicy write_policy = WritePolicy::WRITE_BACK;
+        AllocationPolicy alloc_policy = AllocationPolicy::READ_ALLOCATE;
+        uint64_t address_bits = 48;
+        size_t chunk = NextUseTable::DEFAULT_CHUNK;
+    };
+
+    struct PolicyResult {
+        ReplacementPolicy policy;
+        CacheStats stats; // с разбивкой по наборам
+    };
+
+    using AccessReaderFactory = std::function<std::unique_ptr<AccessReader>()>;
+
+    // Два прохода по трассе: таблица следующих обращений, затем OPT и все
+    // остальные политики (PLRU - если ассоциативность степень двойки) на одном
+    // потоке обращений. open открывает трассу заново на каждый проход.
+    // Результат OPT - первым
+    std::vector<PolicyResult> compare_with_opt(const OptConfig& config, const AccessReaderFactory& open);
+
+    // policy,set,accesses,misses,miss_ratio,opt_misses,gap; set = all - весь кэш,
+    // с per_set - ещё строки по наборам, к которым были обращения
+    void write_opt_gap_csv(std::ostream& out, const std::vector<PolicyResult>& results, bool per_set);
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace Cache {
+
+    constexpr unsigned PAGE_BITS = 12;
+    constexpr uint64_t PAGE_SIZE = uint64_t{1} << PAGE_BITS;   // 4 KB
+    constexpr size_t PAGE_WORDS = PAGE_SIZE / sizeof(int);
+
+    constexpr size_t PAGE_BLOCKS = 64; // блоков памяти (Data) на странице, по биту маски на блок
+
+    struct Page {
+        std::array<int, PAGE_WORDS> words;
+        uint64_t written_blocks;  // блоки, в которые хоть раз писали
+        uint64_t changed_blocks;  // блоки, изменённые после последнего отчёта
+    };
+
+    // Радиксное дерево номеров страниц: четыре уровня по 13 бит покрывают
+    // 64-битный адрес, поиск - четыре индексации массивов без хеширования.
+    // Узлы и страницы заводятся только при insert; последняя найденная страница
+    // запоминается, так что подряд идущие обращения к странице не спускаются по дереву
+    class PageTable {
+    private:
+        static constexpr unsigned LEVEL_BITS = 13;
+        static constexpr size_t FANOUT = size_t{1} << LEVEL_BITS;
+        static constexpr uint64_t NO_PAGE = static_cast<uint64_t>(-1);
+
+        struct Leaf { std::array<std::unique_ptr<Page>, FANOUT> pages; };
+        struct Middle { std::array<std::unique_ptr<Leaf>, FANOUT> leaves; };
+        struct Upper { std::array<std::unique_ptr<Middle>, FANOUT> middles; };
+
+        std::array<std::unique_ptr<Upper>, FANOUT> _root;
+        size_t _pages = 0;
+        mutable uint64_t _last_number = NO_PAGE;
+        mutable Page* _last_page = nullptr;
+
+        static size_t slot(uint64_t number, unsigned level) {
+            return static_cast<size_t>(number >> (LEVEL_BITS * level)) & (FANOUT - 1);
+        }
+    public:
+        static uint64_t page_number(uint64_t address) { return address >> PAGE_BITS; }
+
+        // nullptr, если страница не заведена
+        Page* find(uint64_t number) const {
+            if (number == _last_number) return _last_page;
+            const Upper* upper = _root[slot(number, 3)].get();
+            const Middle* middle = upper ? upper->middles[slot(number, 2)].get() : nullptr;
+            const Leaf* leaf = middle ? middle->leaves[slot(number, 1)].get() : nullptr;
+            Page* page = leaf ? leaf->pages[slot(number, 0)].get() : nullptr;
+            if (page) {
+                _last_number = number;
+                _last_page = page;
+            }
+            return page;
+        }
+
+        // Заводит страницу (содержимое не инициализировано) или возвращает существующую;
+        // inserted сообщает, новая ли она
+        Page* insert(uint64_t number, bool& inserted) {
+            auto& upper = _root[slot(number, 3)];
+            if (!upper) upper = std::make_unique<Upper>();
+            auto& middle = upper->middles[slot(number, 2)];
+            if (!middle) middle = std::make_unique<Middle>();
+            auto& leaf = middle->leaves[slot(number, 1)];
+            if (!leaf) leaf = std::make_unique<Leaf>();
+            auto& page = leaf->pages[slot(number, 0)];
+            inserted = !page;
+            if (inserted) {
+                page.reset(new Page); // без обнуления: вызывающий сам заполняет страницу
+                ++_pages;
+            }
+            _last_number = number;
+            _last_page = page.get();
+            return page.get();
+        }
+
+        size_t pages() const { return _pages; }
+
+        void clear() {
+            for (auto& upper : _root) upper.reset();
+            _pages = 0;
+            _last_number = NO_PAGE;
+            _last_page = nullptr;
+        }
+
+        // Заведённые страницы по возрастанию номера
+        template <typename Visit>
+        void for_each(Visit visit) const {
+            for (size_t u = 0; u < FANOUT; ++u) {
+                if (!_root[u]) continue;
+                for (size_t m = 0; m < FANOUT; ++m) {
+                    const Middle* middle = _root[u]->middles[m].get();
+                    if (!middle) continue;
+                    for (size_t l = 0; l < FANOUT; ++l) {
+                        const Leaf* leaf = middle->leaves[l].get();
+                        if (!leaf) continue;
+                        for (size_t p = 0; p < FANOUT; ++p) {
+                            if (!leaf->pages[p]) continue;
+                            uint64_t number = (uint64_t{u} << (3 * LEVEL_BITS)) | (uint64_t{m} << (2 * LEVEL_BITS)) |
+                                              (uint64_t{l} << LEVEL_BITS) | p;
+                            visit(number, *leaf->pages[p]);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "memory.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Cache {
+
+    // Один уровень кэша над памятью, моделируемый на нескольких потоках. Наборы друг
+    // от друга не зависят, поэтому поток обращений делится по номеру набора: шард s
+    // получает наборы с index % shards == s и сам является MemoryHierarchy из одного
+    // Cache с shards-кратно меньшим числом наборов над собственной памятью. Адрес
+    // переводится в шард без младших бит номера набора и обратно, так что результаты
+    // (попадания, вытеснения, пути, запросы вниз), счётчики уровня и обращения к памяти
+    // совпадают с MemoryHierarchy из одного Cache той же геометрии, в порядке программы.
+    // Память шардов начинается с нулей: её адреса - адреса внутри шарда.
+    //
+    // Независимость наборов есть только у LRU, MRU, PLRU, NRU и SRRIP без адаптивной
+    // вставки; для RANDOM, BRRIP и InsertionPolicy, отличной от NORMAL, генератор или
+    // PSEL общие на весь кэш, и такой кэш остаётся одним шардом.
+    //
+    // Пакет раскладывается по шардам за один проход вызывающим потоком, шарды
+    // обрабатывают постоянные потоки, запущенные в конструкторе
+    class SetPartitionedCache {
+    private:
+        size_t _threads;
+        size_t _shard_bits;
+        size_t _offset_bits;
+        size_t _index_bits;
+
+        struct Shard {
+            std::shared_ptr<Cache> cache;
+            std::shared_ptr<MemoryModel> memory;
+            std::unique_ptr<MemoryHierarchy> hierarchy;
+        };
+        std::vector<Shard> _shards;
+
+        // Номера обращений пакета, сгруппированные по шардам в порядке программы:
+        // шард s - _order[_shard_begin[s]] .. _order[_shard_begin[s + 1] - 1]
+        std::vector<uint32_t> _shard_ids;
+        std::vector<uint32_t> _order;
+        std::vector<size_t> _shard_begin;
+
+        // Пакет для рабочих потоков; _generation растёт с каждым пакетом
+        const InQuery* _queries = nullptr;
+        OutQuery* _results = nullptr;
+        std::mutex _mutex;
+        std::condition_variable _batch_ready;
+        std::condition_variable _batch_done;
+        uint64_t _generation = 0;
+        size_t _running = 0;
+        bool _stopping = false;
+        std::vector<std::thread> _workers;
+
+        uint64_t to_shard(uint64_t address) const;
+        uint64_t from_shard(uint64_t address, size_t shard) const;
+        size_t shard_of(uint64_t address) const {
+            return (address >> _offset_bits) & ((size_t{1} << _shard_bits) - 1);
+        }
+        void partition(const InQuery* queries, size_t count);
+        void run_shards(size_t first_shard);
+        void work(size_t first_shard);
+    public:
+        // threads == 0 - по числу ядер
+        SetPartitionedCache(size_t size, uint64_t block_size, size_t associativity, uint64_t address_bits,
+                            WritePolicy wp, AllocationPolicy ap, ReplacementPolicy rp,
+                            InsertionPolicy insertion = InsertionPolicy::NORMAL, size_t threads = 0);
+        ~SetPartitionedCache();
+
+        SetPartitionedCache(const SetPartitionedCache&) = delete;
+        SetPartitionedCache& operator=(const SetPartitionedCache&) = delete;
+
+        static bool sets_independent(ReplacementPolicy rp, InsertionPolicy insertion);
+
+        // Как MemoryHierarchy::query_batch; на каждый пакет потоки один раз будятся и
+        // синхронизируются, поэтому выгодно передавать трассу большими пакетами
+        void query_batch(const InQuery* queries, size_t count, OutQuery* results);
+
+        void set_data_mode(DataMode mode);
+        void seed_replacement(uint64_t seed);
+
+        size_t shards() const { return _shards.size(); }
+        size_t threads() const { return _threads; }
+
+        // Счётчики шардов, сведённые к нумерации наборов целого кэша
+        CacheStats get_stats() const;
+        // Обращения к памяти всех шардов
+        MemoryStats get_memory_stats() const;
+    };
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "memory.hpp"
+#include "trace.hpp"
+
+namespace Cache {
+
+    // Конвейерный прогон трассы для run_tests --pipeline. Поток разбора декодирует
+    // текстовую или двоичную трассу в пакеты InQuery и передаёт их через кольцо SPSC,
+    // текущий поток моделирует, а весь вывод std::cout уходит блоками через второе
+    // кольцо в поток вывода. Вывод и итоговое состояние совпадают с последовательным
+    // run_tests; повреждённая двоичная трасса - исключение после вывода всего, что
+    // было до неё
+    void run_pipelined_trace(const MappedFile& file, const std::string& name,
+                             std::shared_ptr<MemoryHierarchy> hierarchy);
+
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace Cache {
+
+    enum class ReplacementPolicy {
+        LRU,    // Least Recently Used
+        MRU,    // Most Recently Used
+        RANDOM,
+        PLRU,   // Tree pseudo-LRU, ассоциативность - степень двойки
+        NRU,    // Not Recently Used: бит обращения на путь
+        SRRIP,  // Static RRIP: 2-битный RRPV, вставка с RRPV = 2
+        BRRIP,  // Bimodal RRIP: вставка с RRPV = 3, изредка с RRPV = 2
+        OPT     // Belady: будущее сообщается снаружи через Cache::set_next_use
+    };
+
+    // Генератор xorshift64*: у каждого кэша свой, поэтому прогоны с одним seed воспроизводимы
+    class XorShift {
+    private:
+        uint64_t _state;
+    public:
+        explicit XorShift(uint64_t seed = 1) { this->seed(seed); }
+
+        void seed(uint64_t seed) { _state = seed ? seed : 0x9E3779B97F4A7C15ULL; }
+
+        uint64_t next() {
+            _state ^= _state >> 12;
+            _state ^= _state << 25;
+            _state ^= _state >> 27;
+            return _state * 0x2545F4914F6CDD1DULL;
+        }
+    };
+
+    // Битовые поля наборов: по words слов на набор, бит i набора - i-й путь (или узел дерева)
+    class SetBits {
+    private:
+        size_t _words;
+        uint64_t _last_mask;
+        std::vector<uint64_t> _bits;
+    public:
+        SetBits(size_t sets, size_t bits_per_set)
+            : _words((bits_per_set + 63) / 64),
+              _last_mask(bits_per_set % 64 ? (1ULL << (bits_per_set % 64)) - 1 : ~0ULL),
+              _bits(sets * _words, 0) {}
+
+        size_t words() const { return _words; }
+        // Маска существующих бит в слове word
+        uint64_t word_mask(size_t word) const { return word + 1 == _words ? _last_mask : ~0ULL; }
+
+        uint64_t* set(size_t index) { return _bits.data() + index * _words; }
+        const uint64_t* set(size_t index) const { return _bits.data() + index * _words; }
+
+        void prefetch(size_t index) const { __builtin_prefetch(set(index)); }
+
+        bool test(size_t index, size_t bit) const { return (set(index)[bit / 64] >> (bit % 64)) & 1ULL; }
+        void assign(size_t index, size_t bit, bool value) {
+            uint64_t& word = set(index)[bit / 64];
+            uint64_t mask = 1ULL << (bit % 64);
+            word = value ? (word | mask) : (word & ~mask);
+        }
+    };
+
+    // Состояние политики вытеснения для всех наборов кэша. Вызывается только для
+    // занятых путей: свободные пути кэш заполняет по порядку сам
+    class ReplacementState {
+    public:
+        virtual ~ReplacementState() = default;
+
+        virtual void on_hit(size_t index, size_t way) = 0;
+        virtual void on_fill(size_t index, size_t way) = 0;
+        // Вставка в дальнюю позицию, первым кандидатом на вытеснение (BIP, BRRIP)
+        virtual void on_fill_distant(size_t index, size_t way) = 0;
+        // Путь для вытеснения из полностью занятого набора
+        virtual size_t victim(size_t index) = 0;
+
+        virtual void seed(uint64_t) {}
+        // Номер следующего обращения к блоку текущего обращения; нужен только OPT
+        virtual void set_next_use(uint64_t) {}
+        // Подтягивает в кэш процессора состояние набора перед обращением к нему
+        virtual void prefetch(size_t) const {}
+    };
+
+    class LruPolicy final : public ReplacementState {
+    private:
+        size_t _ways;
+        uint64_t _clock = 0;
+        std::vector<uint64_t> _stamps; // момент последнего обращения к пути
+    public:
+        LruPolicy(size_t sets, size_t ways) : _ways(ways), _stamps(sets * ways, 0) {}
+
+        void on_hit(size_t index, size_t way) override { _stamps[index * _ways + way] = ++_clock; }
+        void on_fill(size_t index, size_t way) override { _stamps[index * _ways + way] = ++_clock; }
+        void on_fill_distant(size_t index, size_t way) override { _stamps[index * _ways + way] = 0; }
+        size_t victim(size_t index) override;
+        void prefetch(size_t index) const override { __builtin_prefetch(_stamps.data() + index * _ways); }
+    };
+
+    class MruPolicy final : public ReplacementState {
+    private:
+        std::vector<uint16_t> _last; // последний путь, к которому обращались в наборе
+    public:
+        MruPolicy(size_t sets, size_t) : _last(sets, 0) {}
+
+        void on_hit(size_t index, size_t way) override { _last[index] = static_cast<uint16_t>(way); }
+        void on_fill(size_t index, size_t way) override { _last[index] = static_cast<uint16_t>(way); }
+        // Для MRU ближайший кандидат на вытеснение и есть только что вставленный блок
+        void on_fill_distant(size_t index, size_t way) override { on_fill(index, way); }
+        size_t victim(size_t index) override { return _last[index]; }
+        void prefetch(size_t index) const override { __builtin_prefetch(_last.data() + index); }
+    };
+
+    class RandomPolicy final : public ReplacementState {
+    private:
+        size_t _ways;
+        XorShift _rng;
+    public:
+        RandomPolicy(size_t, size_t ways) : _ways(ways) {}
+
+        void on_hit(size_t, size_t) override {}
+        void on_fill(size_t, size_t) override {}
+        void on_fill_distant(size_t, size_t) override {}
+        size_t victim(size_t) override { return _rng.next() % _ways; }
+        void seed(uint64_t seed) override { _rng.seed(seed); }
+    };
+
+    // Бинарное дерево из ways - 1 бит (узлы 1..ways-1 в порядке кучи),
+    // бит узла указывает на поддерево, из которого вытеснять
+    class TreePlruPolicy final : public ReplacementState {
+    private:
+        size_t _ways;
+        size_t _levels;
+        SetBits _tree;
+    public:
+        TreePlruPolicy(size_t sets, size_t ways);
+
+        void on_hit(size_t index, size_t way) override { touch(index, way); }
+        void on_fill(size_t index, size_t way) override { touch(index, way); }
+        // Дерево не обновляется и продолжает указывать на вытесненный путь
+        void on_fill_distant(size_t, size_t) override {}
+        size_t victim(size_t index) override;
+        void prefetch(size_t index) const override { _tree.prefetch(index); }
+    private:
+        void touch(size_t index, size_t way);
+    };
+
+    class NruPolicy final : public ReplacementState {
+    private:
+        SetBits _referenced;
+    public:
+        NruPolicy(size_t sets, size_t ways) : _referenced(sets, ways) {}
+
+        void on_hit(size_t index, size_t way) override { touch(index, way); }
+        void on_fill(size_t index, size_t way) override { touch(index, way); }
+        void on_fill_distant(size_t index, size_t way) override { _referenced.assign(index, way, false); }
+        size_t victim(size_t index) override;
+        void prefetch(size_t index) const override { _referenced.prefetch(index); }
+    private:
+        void touch(size_t index, size_t way);
+    };
+
+    // RRPV хранится в двух битовых плоскостях (старший и младший бит),
+    // так что поиск RRPV = 3 и старение набора - операции над словами
+    class RripPolicy final : public ReplacementState {
+    public:
+        static constexpr unsigned BIMODAL_THROTTLE = 32; // BRRIP: 1 из 32 вставок с RRPV = 2
+    private:
+        bool _bimodal;
+        SetBits _high;
+        SetBits _low;
+        XorShift _rng;
+    public:
+        RripPolicy(size_t sets, size_t ways, bool bimodal)
+            : _bimodal(bimodal), _high(sets, ways), _low(sets, ways) {}
+
+        void on_hit(size_t index, size_t way) override { set_rrpv(index, way, 0); }
+        void on_fill(size_t index, size_t way) override {
+            bool distant = _bimodal && _rng.next() % BIMODAL_THROTTLE != 0;
+            set_rrpv(index, way, distant ? 3 : 2);
+        }
+        void on_fill_distant(size_t index, size_t way) override { set_rrpv(index, way, 3); }
+        size_t victim(size_t index) override;
+        void seed(uint64_t seed) override { _rng.seed(seed); }
+        void prefetch(size_t index) const override {
+            _high.prefetch(index);
+            _low.prefetch(index);
+        }
+    private:
+        void set_rrpv(size_t index, size_t way, unsigned rrpv) {
+            _high.assign(index, way, rrpv & 2);
+            _low.assign(index, way, rrpv & 1);
+        }
+    };
+
+    // Вытесняется блок, к которому дольше всего не будет обращений. Перед каждым
+    // обращением к кэшу set_next_use сообщает, когда в следующий раз понадобится
+    // его блок; попадание или заполнение запоминает это значение для пути
+    class OptPolicy final : public ReplacementState {
+    public:
+        static constexpr uint64_t NEVER = static_cast<uint64_t>(-1);
+    private:
+        size_t _ways;
+        uint64_t _pending = NEVER;
+        std::vector<uint64_t> _next_use;
+    public:
+        OptPolicy(size_t sets, size_t ways) : _ways(ways), _next_use(sets * ways, NEVER) {}
+
+        void set_next_use(uint64_t next) override { _pending = next; }
+        void on_hit(size_t index, size_t way) override { _next_use[index * _ways + way] = _pending; }
+        void on_fill(size_t index, size_t way) override { _next_use[index * _ways + way] = _pending; }
+        void on_fill_distant(size_t index, size_t way) override { on_fill(index, way); }
+        size_t victim(size_t index) override;
+        void prefetch(size_t index) const override { __builtin_prefetch(_next_use.data() + index * _ways); }
+    };
+
+    enum class InsertionPolicy {
+        NORMAL,   // вставка по правилу политики вытеснения (MRU-позиция, RRPV = 2)
+        BIMODAL,  // вставка в дальнюю позицию, изредка в ближнюю (BIP, BRRIP)
+        ADAPTIVE  // set dueling между NORMAL и BIMODAL (DIP для LRU, DRRIP для SRRIP)
+    };
+
+    // Выбор позиции вставки. В режиме ADAPTIVE часть наборов - лидеры, всегда
+    // использующие одну из политик; промахи в них двигают насыщающийся счётчик PSEL,
+    // по которому остальные наборы (ведомые) выбирают политику. Лидеров не больше
+    // половины наборов, поэтому ADAPTIVE требует не меньше MIN_ADAPTIVE_SETS наборов,
+    // иначе конструктор бросает std::invalid_argument
+    class InsertionController {
+    public:
+        static constexpr size_t MIN_ADAPTIVE_SETS = 16;
+        static constexpr unsigned PSEL_BITS = 10;
+        static constexpr unsigned PSEL_MAX = (1u << PSEL_BITS) - 1;
+        static constexpr unsigned BIMODAL_THROTTLE = 32;   // 1 из 32 бимодальных вставок - ближняя
+        static constexpr uint64_t SAMPLE_PERIOD = 4096;    // обращений между отсчётами PSEL
+    private:
+        enum class SetRole : uint8_t { FOLLOWER, LEADER_NORMAL, LEADER_BIMODAL };
+        // Политика, которой в последний раз заполнялся ведомый набор
+        enum class LastChoice : uint8_t { NONE, NORMAL, BIMODAL };
+
+        InsertionPolicy _policy;
+        unsigned _psel = PSEL_MAX / 2;
+        std::vector<SetRole> _roles;
+        std::vector<LastChoice> _last_choice;
+        std::vector<uint16_t> _psel_history;
+        uint64_t _accesses = 0;
+        uint64_t _follower_fills[2] = {0, 0};
+        XorShift _rng;
+    public:
+        InsertionController(InsertionPolicy policy, size_t sets);
+
+        static bool supports(InsertionPolicy policy, size_t sets) {
+            return policy != InsertionPolicy::ADAPTIVE || sets >= MIN_ADAPTIVE_SETS;
+        }
+
+        // Вызывается на каждое обращение к кэшу до заполнения
+        void on_access(size_t index, bool hit) {
+            if (_policy == InsertionPolicy::ADAPTIVE) {
+                if (!hit) {
+                    if (_roles[index] == SetRole::LEADER_NORMAL && _psel < PSEL_MAX) ++_psel;
+                    if (_roles[index] == SetRole::LEADER_BIMODAL && _psel > 0) --_psel;
+                }
+                if (++_accesses % SAMPLE_PERIOD == 0) _psel_history.push_back(static_cast<uint16_t>(_psel));
+            }
+        }
+
+        // true - вставлять в дальнюю позицию
+        bool insert_distant(size_t index);
+
+        void seed(uint64_t seed) { _rng.seed(seed); }
+
+        InsertionPolicy policy() const { return _policy; }
+        unsigned psel() const { return _psel; }
+        const std::vector<uint16_t>& psel_history() const { return _psel_history; }
+        size_t leader_sets(bool bimodal) const;
+        // Число ведомых наборов, последний раз заполненных политикой NORMAL / BIMODAL
+        size_t follower_sets(bool bimodal) const;
+        uint64_t follower_fills(bool bimodal) const { return _follower_fills[bimodal]; }
+
+        void print_state(std::ostream& out) const;
+    private:
+        bool bimodal_draw() { return _rng.next() % BIMODAL_THROTTLE != 0; }
+    };
+
+    std::unique_ptr<ReplacementState> make_replacement(ReplacementPolicy policy, size_t sets, size_t ways);
+
+    // Конкретный тип политики для StaticCache: вызовы через final-класс не виртуальные
+    template <ReplacementPolicy RP> struct ReplacementFor;
+    template <> struct ReplacementFor<ReplacementPolicy::LRU> { using type = LruPolicy; };
+    template <> struct ReplacementFor<ReplacementPolicy::MRU> { using type = MruPolicy; };
+    template <> struct ReplacementFor<ReplacementPolicy::RANDOM> { using type = RandomPolicy; };
+    template <> struct ReplacementFor<ReplacementPolicy::PLRU> { using type = TreePlruPolicy; };
+    template <> struct ReplacementFor<ReplacementPolicy::NRU> { using type = NruPolicy; };
+    template <> struct ReplacementFor<ReplacementPolicy::SRRIP> { using type = RripPolicy; };
+    template <> struct ReplacementFor<ReplacementPolicy::BRRIP> { using type = RripPolicy; };
+    template <> struct ReplacementFor<ReplacementPolicy::OPT> { using type = OptPolicy; };
+
+}
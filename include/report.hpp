@@ -0,0 +1,93 @@
+#pragma once
+
+#include "buffered_writer.hpp"
+#include "cache.hpp"
+#include "stats.hpp"
+
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+namespace Cache {
+
+    enum class OutputFormat {
+        TEXT,  // прежний вывод для человека
+        CSV,   // строка на событие, первый столбец - тип события
+        JSON,  // объект JSON на строку, тип события в поле "event"
+        NONE   // без событий, остаётся только итоговая статистика
+    };
+
+    // text, csv, json, none; ошибка - std::invalid_argument
+    OutputFormat parse_output_format(std::string_view name);
+
+    // Весь вывод модели о ходе прогона: эхо команд, обращения к уровням и памяти,
+    // прочитанные данные, блоки памяти, состояние кэшей и статистика. События копятся
+    // в буфере на CAPACITY байт и уходят в поток целыми кусками - поток не сбрасывается
+    // на каждой строке. Содержимое буфера уходит в поток при flush и при text(), поэтому
+    // перед прямой записью в тот же поток вывод нужно сбросить.
+    //
+    // Столбцы CSV по типам событий (заголовка нет, набор столбцов зависит от типа):
+    //   command,<строка трассы>
+    //   access,<уровень>,<read|write>,<адрес>,<размер>,<hit|miss>,<вытесненный тег>,<данные>
+    //   mem,<read|write>,<адрес>,<размер>,<элементов>,<записанные данные>
+    //   data,<прочитанные данные>
+    //   block,<адрес>,<данные блока памяти>
+    //   cache_block,<уровень>,<набор>,<путь>,<тег>,<адрес>,<dirty|clean>,<данные>
+    //   stats,<имя>,accesses,hits,misses,reads,read_hits,writes,write_hits,fills,evictions,
+    //         dirty_writebacks,write_throughs,bypasses
+    //   memory_stats,<чтений>,<записей>
+    // Адреса и теги - 0x..., значения данных - через пробел. В JSON те же поля по именам
+    class ReportSink {
+    public:
+        static constexpr size_t CAPACITY = 1 << 20;
+    private:
+        OutputFormat _format;
+        std::ostream& _stream;
+        BufferedWriter _out;
+
+        void values(const int* data, size_t count, std::string_view separator);
+        void json_values(const int* data, size_t count);
+        void quoted(std::string_view text);
+    public:
+        explicit ReportSink(std::ostream& out, OutputFormat format = OutputFormat::TEXT)
+            : _format(format), _stream(out), _out(out, CAPACITY) {}
+
+        OutputFormat format() const { return _format; }
+        bool enabled() const { return _format != OutputFormat::NONE; }
+        bool structured() const { return _format == OutputFormat::CSV || _format == OutputFormat::JSON; }
+
+        // Строка трассы перед её исполнением
+        void command(std::string_view line);
+        // Обращение к уровню level; detailed - с данными ответа и вытесненным тегом
+        void access(size_t level, const InQuery& query, const OutQuery& result, bool detailed);
+        // Обращение к памяти; data - записанные элементы или nullptr
+        void memory_access(const InQuery& query, size_t elements, const int* data, size_t count);
+        // Прочитанные командой ld данные
+        void loaded(const Data& data, size_t count);
+        // Заголовок таблицы блоков памяти (только в текстовом виде) и её строки
+        void begin_blocks(std::string_view title);
+        void memory_block(uint64_t address, const Data& block);
+        // Блок кэша для структурированных форматов; data == nullptr в режиме TAGS_ONLY
+        void cache_block(size_t level, size_t set, size_t way, uint64_t tag, uint64_t address,
+                         bool dirty, const Data* data);
+        void cache_stats(const std::string& name, const CacheStats& stats);
+        void memory_stats(const MemoryStats& stats);
+
+        // Поток для текстового вывода, который пишется мимо событий (состояние кэшей,
+        // статистика): буфер сбрасывается, чтобы сохранить порядок
+        std::ostream& text() {
+            flush();
+            return _stream;
+        }
+
+        void flush() {
+            _out.flush();
+            _stream.flush();
+        }
+    };
+
+    // Общий для процесса текстовый вывод в std::cout: им пользуются все модели памяти,
+    // пока им не назначен другой через MemoryModel::set_report
+    std::shared_ptr<ReportSink> standard_report();
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "cache.hpp"
+
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace Cache {
+
+    // Стековые расстояния LRU (алгоритм Маттсона) за один проход. Расстояние
+    // обращения - число разных блоков между ним и предыдущим обращением к тому же
+    // блоку; LRU из C блоков попадает тогда и только тогда, когда расстояние < C.
+    // Дерево Фенвика по моментам последних обращений даёт расстояние за O(log M),
+    // где M - число разных блоков; моменты периодически перенумеровываются, чтобы
+    // дерево не росло с длиной трассы
+    class StackDistanceCounter {
+    private:
+        static constexpr size_t MIN_TREE = 1 << 10;
+
+        std::unordered_map<uint64_t, uint64_t> _last; // блок -> момент последнего обращения
+        std::vector<uint32_t> _tree;                   // отметки моментов последних обращений
+        uint64_t _time = 0;
+        uint64_t _accesses = 0;
+        uint64_t _cold = 0;
+        std::vector<uint64_t> _histogram;              // число обращений по расстояниям
+
+        void add(uint64_t position, int32_t delta);
+        uint64_t prefix(uint64_t position) const;      // отметок в [0, position)
+        void compact();
+    public:
+        StackDistanceCounter() : _tree(MIN_TREE, 0) {}
+
+        static constexpr uint64_t COLD = static_cast<uint64_t>(-1);
+
+        // Расстояние обращения к block или COLD для первого обращения
+        uint64_t access(uint64_t block);
+
+        uint64_t accesses() const { return _accesses; }
+        uint64_t cold_misses() const { return _cold; }
+        const std::vector<uint64_t>& histogram() const { return _histogram; }
+
+        // Промахи LRU на capacity блоков
+        uint64_t misses(size_t capacity) const;
+    };
+
+    // Кривые промахов LRU сразу для нескольких чисел наборов при одном размере
+    // блока. Адрес раскладывается на набор и тег тем же AddressLayout, что и в
+    // моделируемом кэше, и у каждого набора свой стек; sets == 1 -
+    // полностью ассоциативный кэш. Кривые совпадают со счётчиками Cache с LRU и
+    // AllocationPolicy::BOTH: промах заводит блок и при чтении, и при записи
+    class ReuseAnalyzer {
+    private:
+        struct Variant {
+            size_t sets;
+            AddressLayout layout;
+            std::vector<StackDistanceCounter> stacks;
+        };
+
+        uint64_t _block_size;
+        std::vector<Variant> _variants;
+
+        // Гистограмма расстояний, сложенная по наборам, и число холодных промахов
+        static std::vector<uint64_t> merged_histogram(const Variant& variant, uint64_t& cold);
+    public:
+        ReuseAnalyzer(uint64_t block_size, const std::vector<size_t>& set_counts);
+
+        void access(uint64_t address);
+
+        // Промахи для sets наборов по ways путей
+        uint64_t misses(size_t sets, size_t ways) const;
+        uint64_t accesses() const;
+
+        // sets,ways,capacity,accesses,misses,miss_ratio. Для sets > 1 - ассоциативности
+        // 1..max_ways; для sets == 1 - ёмкости-степени двойки, пока промахи не сведутся к холодным
+        void write_curves_csv(std::ostream& out, size_t max_ways) const;
+        // sets,distance,count; расстояние cold - первые обращения
+        void write_histogram_csv(std::ostream& out) const;
+    };
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace Cache {
+
+    // Кольцо без блокировок на одного писателя и одного читателя. Элементы
+    // заполняются и читаются на месте: писатель берёт свободный слот через
+    // acquire, заполняет и публикует commit; читатель получает слот через front
+    // и возвращает его release. Слоты переиспользуются, ничего не копируется
+    template <typename T, size_t Capacity>
+    class SpscRing {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+        static constexpr size_t MASK = Capacity - 1;
+        static constexpr size_t CACHE_LINE = 64;
+        static constexpr unsigned SPINS_BEFORE_YIELD = 64;
+
+        // Счётчики писателя и читателя на разных строках, чтобы не делить строку между ядрами
+        alignas(CACHE_LINE) std::atomic<size_t> _tail{0}; // публикует писатель
+        size_t _cached_head = 0;                          // копия _head у писателя
+        alignas(CACHE_LINE) std::atomic<size_t> _head{0}; // публикует читатель
+        size_t _cached_tail = 0;                          // копия _tail у читателя
+        alignas(CACHE_LINE) std::array<T, Capacity> _slots;
+
+        template <typename Try>
+        static auto wait(Try&& attempt) {
+            for (unsigned spins = 0;; ++spins) {
+                if (auto* slot = attempt()) return slot;
+                if (spins >= SPINS_BEFORE_YIELD) std::this_thread::yield();
+            }
+        }
+
+    public:
+        // Писатель: свободный слот или nullptr, если кольцо заполнено
+        T* try_acquire() {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _cached_head == Capacity) {
+                _cached_head = _head.load(std::memory_order_acquire);
+                if (tail - _cached_head == Capacity) return nullptr;
+            }
+            return &_slots[tail & MASK];
+        }
+
+        T& acquire() { return *wait([this] { return try_acquire(); }); }
+
+        void commit() {
+            _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Читатель: самый старый опубликованный слот или nullptr, если кольцо пусто
+        T* try_front() {
+            size_t head = _head.load(std::memory_order_relaxed);
+            if (head == _cached_tail) {
+                _cached_tail = _tail.load(std::memory_order_acquire);
+                if (head == _cached_tail) return nullptr;
+            }
+            return &_slots[head & MASK];
+        }
+
+        T& front() { return *wait([this] { return try_front(); }); }
+
+        void release() {
+            _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    };
+
+}
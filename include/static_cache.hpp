@@ -0,0 +1,68 @@
+#pragma once
+
+#include "cache_impl.hpp"
+#include <memory>
+
+namespace Cache {
+
+    constexpr size_t log2_exact(size_t value) {
+        size_t bits = 0;
+        while ((size_t{1} << bits) < value) ++bits;
+        return bits;
+    }
+
+    constexpr bool is_power_of_two(size_t value) {
+        return value != 0 && (value & (value - 1)) == 0;
+    }
+
+    // Геометрия и политики, зафиксированные на этапе компиляции: сдвиги и маски
+    // становятся константами, а ветвления по политикам в query_impl сворачиваются
+    template <size_t Size, size_t Block, size_t Assoc,
+              WritePolicy WP, AllocationPolicy AP, ReplacementPolicy RP>
+    struct StaticConfig {
+        static_assert(is_power_of_two(Block), "block size must be a power of two");
+        static_assert(Size % (Block * Assoc) == 0, "size must be a multiple of block size * associativity");
+        static_assert(is_power_of_two(Size / (Block * Assoc)), "number of sets must be a power of two");
+
+        using Replacement = typename ReplacementFor<RP>::type;
+
+        static constexpr size_t associativity = Assoc;
+        static constexpr size_t offset_bits = log2_exact(Block);
+        static constexpr size_t index_bits = log2_exact(Size / (Block * Assoc));
+        static constexpr WritePolicy write_policy = WP;
+        static constexpr AllocationPolicy alloc_policy = AP;
+        static constexpr ReplacementPolicy repl_policy = RP;
+    };
+
+    template <size_t Size, size_t Block, size_t Assoc,
+              WritePolicy WP, AllocationPolicy AP, ReplacementPolicy RP>
+    class StaticCache : public Cache {
+    public:
+        using Config = StaticConfig<Size, Block, Assoc, WP, AP, RP>;
+
+        explicit StaticCache(uint64_t address_bits)
+            : Cache(Size, Block, Assoc, address_bits, WP, AP, RP) {}
+
+        static bool matches(size_t size, uint64_t block_size, size_t associativity,
+                            WritePolicy wp, AllocationPolicy ap, ReplacementPolicy rp) {
+            return size == Size && block_size == Block && associativity == Assoc &&
+                   wp == WP && ap == AP && rp == RP;
+        }
+
+        auto query(InQuery const& query) -> OutQuery override {
+            OutQuery result;
+            query_impl(Config{}, query, result);
+            return result;
+        }
+
+        void query_batch(const InQuery* queries, size_t count, OutQuery* results) override {
+            query_batch_impl(Config{}, queries, count, results);
+        }
+    };
+
+    // Создаёт StaticCache, если для параметров есть готовая специализация,
+    // иначе обычный Cache с параметрами времени выполнения
+    std::shared_ptr<Cache> make_cache(size_t size, uint64_t block_size, size_t associativity, uint64_t address_bits,
+                                      WritePolicy wp, AllocationPolicy ap, ReplacementPolicy rp);
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace Cache {
+
+    // Вектор с фиксированной ёмкостью во встроенном буфере: не обращается к куче
+    // и не конструирует неиспользуемые элементы
+    template <typename T, size_t N>
+    class StaticVector {
+    private:
+        alignas(T) unsigned char _storage[N * sizeof(T)];
+        size_t _size = 0;
+
+    public:
+        StaticVector() = default;
+
+        StaticVector(const StaticVector& other) {
+            for (const auto& value : other) push_back(value);
+        }
+
+        StaticVector(StaticVector&& other) noexcept {
+            for (auto& value : other) push_back(std::move(value));
+            other.clear();
+        }
+
+        StaticVector& operator=(const StaticVector& other) {
+            if (this != &other) {
+                clear();
+                for (const auto& value : other) push_back(value);
+            }
+            return *this;
+        }
+
+        StaticVector& operator=(StaticVector&& other) noexcept {
+            if (this != &other) {
+                clear();
+                for (auto& value : other) push_back(std::move(value));
+                other.clear();
+            }
+            return *this;
+        }
+
+        ~StaticVector() { clear(); }
+
+        template <typename... Args>
+        T& emplace_back(Args&&... args) {
+            if (_size == N) throw std::length_error("StaticVector capacity exceeded");
+            T* value = new (_storage + _size * sizeof(T)) T(std::forward<Args>(args)...);
+            ++_size;
+            return *value;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        void clear() {
+            for (size_t i = 0; i < _size; ++i) data()[i].~T();
+            _size = 0;
+        }
+
+        T* data() { return std::launder(reinterpret_cast<T*>(_storage)); }
+        const T* data() const { return std::launder(reinterpret_cast<const T*>(_storage)); }
+
+        size_t size() const { return _size; }
+        static constexpr size_t capacity() { return N; }
+        bool empty() const { return _size == 0; }
+
+        T& operator[](size_t i) { return data()[i]; }
+        const T& operator[](size_t i) const { return data()[i]; }
+
+        T* begin() { return data(); }
+        T* end() { return data() + _size; }
+        const T* begin() const { return data(); }
+        const T* end() const { return data() + _size; }
+    };
+
+}
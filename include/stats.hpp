@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Cache {
+
+    // Счётчики уровня кэша. Обновляются в query_impl простыми инкрементами,
+    // промахи считаются как разность обращений и попаданий
+    struct CacheStats {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t read_hits = 0;
+        uint64_t write_hits = 0;
+        uint64_t fills = 0;            // блоков заведено при промахе
+        uint64_t evictions = 0;
+        uint64_t dirty_writebacks = 0; // вытесненных грязных блоков, отправленных ниже
+        uint64_t write_throughs = 0;   // записей, сквозь кэш переданных ниже
+        uint64_t bypasses = 0;         // промахов без заведения блока
+
+        std::vector<uint64_t> set_accesses;
+        std::vector<uint64_t> set_misses;
+
+        CacheStats() = default;
+        explicit CacheStats(size_t sets) : set_accesses(sets, 0), set_misses(sets, 0) {}
+
+        uint64_t accesses() const { return reads + writes; }
+        uint64_t hits() const { return read_hits + write_hits; }
+        uint64_t read_misses() const { return reads - read_hits; }
+        uint64_t write_misses() const { return writes - write_hits; }
+        uint64_t misses() const { return accesses() - hits(); }
+        double hit_rate() const { return accesses() ? static_cast<double>(hits()) / accesses() : 0.0; }
+
+        void reset() { *this = CacheStats(set_accesses.size()); }
+        // per_set: добавить строки по наборам, к которым были обращения
+        void print(std::ostream& out, const std::string& name, bool per_set) const;
+    };
+
+    struct MemoryStats {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+
+        void reset() { *this = MemoryStats(); }
+        void print(std::ostream& out) const;
+    };
+
+}
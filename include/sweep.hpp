@@ -0,0 +1,103 @@
+#pragma once
+
+#include "memory.hpp"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Cache {
+
+    // Обращение трассы для перебора конфигураций: 16 байт вместо InQuery.
+    // Значения записей на счётчики не влияют, поэтому не хранятся
+    struct SweepAccess {
+        uint64_t address;
+        uint32_t size;
+        Operation operation;
+    };
+
+    // Потоковое чтение обращений трассы любого формата или синтетической нагрузки,
+    // без загрузки в память целиком. show/stats пропускаются, ошибки текстовой
+    // трассы - в stderr, как в run_tests
+    class AccessReader {
+    private:
+        std::string _path;
+        std::unique_ptr<MappedFile> _file;
+        std::unique_ptr<TextTraceReader> _text;
+        std::unique_ptr<BinaryTraceReader> _binary;
+        std::unique_ptr<ImportedTraceReader> _imported;
+        std::unique_ptr<WorkloadGenerator> _generator;
+        uint64_t _remaining = 0;   // обращений нагрузки до конца
+        TraceRecord _record;
+        std::string _error;
+    public:
+        AccessReader(const std::string& path, TraceFormat format);
+        explicit AccessReader(const WorkloadSpec& spec);
+
+        bool next(SweepAccess& access);
+    };
+
+    // Трасса, разобранная один раз и общая для всех потоков только на чтение
+    std::vector<SweepAccess> load_sweep_trace(const std::string& path, TraceFormat format);
+    std::vector<SweepAccess> load_sweep_trace(const WorkloadSpec& spec);
+
+    struct SweepConfig {
+        size_t size;
+        uint64_t block_size;
+        size_t associativity;
+        WritePolicy write_policy;
+        AllocationPolicy alloc_policy;
+        ReplacementPolicy replacement;
+        size_t levels;           // 1 или 2; у L2 тот же блок и те же политики
+        size_t l2_size;
+        size_t l2_associativity;
+    };
+
+    // Декартово произведение всех списков; конфигурации, которые Cache не
+    // поддерживает (число наборов не степень двойки, PLRU на такой ассоциативности), отбрасываются
+    struct SweepGrid {
+        std::vector<size_t> sizes{4 * 1024};
+        std::vector<uint64_t> block_sizes{64};
+        std::vector<size_t> associativities{4};
+        std::vector<WritePolicy> write_policies{WritePolicy::WRITE_BACK};
+        std::vector<AllocationPolicy> alloc_policies{AllocationPolicy::READ_ALLOCATE};
+        std::vector<ReplacementPolicy> replacements{ReplacementPolicy::LRU};
+        std::vector<size_t> levels{1};
+        std::vector<size_t> l2_sizes{256 * 1024};
+        std::vector<size_t> l2_associativities{8};
+        uint64_t address_bits = 48;
+
+        std::vector<SweepConfig> expand() const;
+    };
+
+    bool is_valid_config(const SweepConfig& config);
+
+    struct SweepResult {
+        SweepConfig config;
+        std::vector<CacheStats> levels; // без разбивки по наборам
+        MemoryStats memory;
+        double seconds = 0;
+    };
+
+    // Одна конфигурация в режиме TAGS_ONLY. Одноуровневая конфигурация с threads > 1
+    // моделируется через SetPartitionedCache, если её наборы независимы
+    SweepResult run_sweep_config(const SweepConfig& config, uint64_t address_bits,
+                                 const std::vector<SweepAccess>& trace, size_t threads = 1);
+
+    // Все конфигурации на threads потоках; результаты - в порядке configs. Если
+    // конфигураций меньше, чем потоков, лишние потоки делят наборы одноуровневых конфигураций
+    std::vector<SweepResult> run_sweep(const std::vector<SweepConfig>& configs, uint64_t address_bits,
+                                       const std::vector<SweepAccess>& trace, size_t threads);
+
+    // По строке CSV на конфигурацию
+    void write_sweep_csv(std::ostream& out, const std::vector<SweepResult>& results);
+
+    // Разбор значений списков перебора; неизвестное имя - std::invalid_argument.
+    // opt не принимается: перебор не строит таблицу следующих обращений (см. opt.hpp)
+    WritePolicy parse_write_policy(std::string_view name);
+    AllocationPolicy parse_alloc_policy(std::string_view name);
+    ReplacementPolicy parse_replacement_policy(std::string_view name);
+    const char* replacement_policy_name(ReplacementPolicy policy);
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Cache {
+
+    // Тег, которым помечены незанятые пути: настоящий тег получается сдвигом адреса
+    // и не может быть равен ему при ненулевом числе бит смещения и индекса
+    constexpr uint64_t INVALID_TAG = ~0ULL;
+
+    // Максимальное число путей, сравниваемых за один вызов (по биту маски на путь)
+    constexpr size_t TAG_MATCH_CHUNK = 64;
+
+    // Маска путей набора, у которых тег совпал с искомым; ways <= TAG_MATCH_CHUNK
+    using TagMatchFn = uint64_t (*)(const uint64_t* tags, size_t ways, uint64_t tag);
+
+    uint64_t tag_match_mask_scalar(const uint64_t* tags, size_t ways, uint64_t tag);
+
+    // Реализация выбирается один раз при запуске по набору инструкций процессора
+    // (AVX2, SSE4.2 или скалярный вариант)
+    extern const TagMatchFn tag_match_mask;
+    const char* tag_match_isa();
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "cache.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace Cache {
+
+    // Записи трассы: обращения ld/st и команды show/stats текстового формата
+    enum class TraceCommand : uint8_t {
+        LOAD,
+        STORE,
+        SHOW,
+        STATS
+    };
+
+    struct TraceRecord {
+        TraceCommand command = TraceCommand::LOAD;
+        InQuery query{Operation::READ, 0, {}, 0};
+    };
+
+    // Разбор строки текстового формата (ld <size> <addr> | st <size> <addr> <val>... | show | stats)
+    // через std::from_chars, без выделения памяти для корректных строк. Адрес и значения -
+    // шестнадцатеричные, с префиксом 0x или без. Для пустой строки возвращает false с пустым
+    // error, для ошибки формата - false и текст ошибки
+    bool parse_trace_line(std::string_view line, TraceRecord& record, std::string& error);
+
+    // Построчный проход по текстовой трассе в памяти (обычно в MappedFile)
+    class TextTraceReader {
+    private:
+        const char* _pos;
+        const char* _end;
+        size_t _line_number = 0;
+    public:
+        TextTraceReader(const char* data, size_t size) : _pos(data), _end(data + size) {}
+        TextTraceReader(const uint8_t* data, size_t size)
+            : TextTraceReader(reinterpret_cast<const char*>(data), size) {}
+
+        // Следующая строка без перевода строки и '\r'; false - текст кончился
+        bool next_line(std::string_view& line);
+        size_t line_number() const { return _line_number; }
+    };
+
+    // Двоичный формат трассы:
+    //   заголовок - "CTRC", байт версии, 3 зарезервированных байта;
+    //   запись    - байт TraceCommand; для LOAD/STORE далее varint размера и
+    //               zigzag-varint разности с адресом предыдущего обращения;
+    //               для STORE - varint числа значений и сами значения, по 4 байта little-endian
+    constexpr char BINARY_TRACE_MAGIC[4] = {'C', 'T', 'R', 'C'};
+    constexpr uint8_t BINARY_TRACE_VERSION = 1;
+    constexpr size_t BINARY_TRACE_HEADER_SIZE = 8;
+
+    enum class MapAccess {
+        SEQUENTIAL,    // только чтение, подряд (трассы)
+        COPY_ON_WRITE  // чтение и запись вразброс; записи остаются в памяти процесса, файл не меняется
+    };
+
+    // Файл, отображённый в память. Страницы подгружаются по обращению, так что
+    // отображение многогигабайтного файла почти ничего не стоит
+    class MappedFile {
+    private:
+        uint8_t* _data = nullptr;
+        size_t _size = 0;
+    public:
+        explicit MappedFile(const std::string& path, MapAccess access = MapAccess::SEQUENTIAL);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* data() const { return _data; }
+        // Только для MapAccess::COPY_ON_WRITE
+        uint8_t* mutable_data() { return _data; }
+        size_t size() const { return _size; }
+    };
+
+    bool is_binary_trace(const uint8_t* data, size_t size);
+
+    // Читает записи прямо из буфера (обычно из MappedFile), ничего не выделяя
+    class BinaryTraceReader {
+    private:
+        const uint8_t* _pos;
+        const uint8_t* _end;
+        uint64_t _prev_address = 0;
+
+        uint64_t read_varint();
+    public:
+        BinaryTraceReader(const uint8_t* data, size_t size);
+
+        // false - записи кончились; повреждённая запись - std::runtime_error
+        bool next(TraceRecord& record);
+    };
+
+    class BinaryTraceWriter {
+    private:
+        std::ostream& _out;
+        uint64_t _prev_address = 0;
+
+        void write_varint(uint64_t value);
+    public:
+        explicit BinaryTraceWriter(std::ostream& out);
+
+        void write(const TraceRecord& record);
+    };
+
+}
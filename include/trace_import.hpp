@@ -0,0 +1,86 @@
+#pragma once
+
+#include "trace.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Cache {
+
+    // Форматы трасс для --test: собственный (текстовый или двоичный, см. trace.hpp)
+    // и трассы сторонних инструментов, которые читаются без промежуточного файла
+    enum class TraceFormat {
+        NATIVE,
+        DINERO,   // Dinero din: "<метка> <адрес>", 0 - чтение, 1 - запись, 2 - выборка команды
+        LACKEY,   // valgrind --tool=lackey: " L|S|M <адрес>,<размер>", строки I - выборка команды
+        CHAMPSIM  // ChampSim: 64-байтные записи input_instr, обычно сжатые xz
+    };
+
+    // "native", "din", "lackey", "champsim"; иначе std::invalid_argument
+    TraceFormat parse_trace_format(const std::string& name);
+
+    // Dinero din и ChampSim не хранят размер обращения: для din это слово,
+    // для ChampSim - машинное слово x86-64
+    constexpr size_t DINERO_ACCESS_SIZE = 4;
+    constexpr size_t CHAMPSIM_ACCESS_SIZE = 8;
+    constexpr size_t CHAMPSIM_RECORD_SIZE = 64;
+
+    // Байты файла с распаковкой на лету: gzip и xz определяются по сигнатуре,
+    // остальное отдаётся как есть. Вход отображается в память, выход - порциями
+    class DecompressingReader {
+    private:
+        struct Decoder;
+
+        MappedFile _file;
+        size_t _offset = 0; // для несжатого файла
+        std::unique_ptr<Decoder> _decoder;
+    public:
+        explicit DecompressingReader(const std::string& path);
+        ~DecompressingReader();
+
+        // До capacity байт в buffer; 0 - файл кончился. Повреждённый поток - std::runtime_error
+        size_t read(uint8_t* buffer, size_t capacity);
+    };
+
+    // Потоковое чтение трасс DINERO, LACKEY и CHAMPSIM в записи LOAD/STORE.
+    // Данные записей STORE неизвестны и заполняются нулями. Выборки команд и
+    // служебные строки пропускаются, ошибка формата - std::runtime_error с номером строки
+    class ImportedTraceReader {
+    private:
+        static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+        DecompressingReader _input;
+        TraceFormat _format;
+        std::vector<uint8_t> _buffer;
+        size_t _begin = 0;
+        size_t _end = 0;
+        bool _eof = false;
+        size_t _position = 0; // номер строки или записи ChampSim
+        size_t _skipped = 0;
+
+        // Инструкция ChampSim или M из lackey дают несколько обращений сразу
+        std::array<TraceRecord, 6> _pending;
+        size_t _pending_count = 0;
+        size_t _pending_next = 0;
+
+        bool fill(size_t bytes);
+        bool next_line(std::string_view& line);
+        void push(TraceCommand command, uint64_t address, size_t size);
+        [[noreturn]] void fail(const std::string& message) const;
+
+        void decode_dinero(std::string_view line);
+        void decode_lackey(std::string_view line);
+        void decode_champsim(const uint8_t* record);
+    public:
+        ImportedTraceReader(const std::string& path, TraceFormat format);
+
+        // false - трасса кончилась
+        bool next(TraceRecord& record);
+
+        // Строки и записи без обращений к данным
+        size_t skipped() const { return _skipped; }
+    };
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "cache.hpp"
+#include "replacement.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Cache {
+
+    class MemoryHierarchy;
+
+    // Синтетические потоки обращений для --gen: подаются в MemoryHierarchy
+    // напрямую, без файла трассы и разбора
+    enum class WorkloadPattern {
+        SEQUENTIAL,    // seq: подряд по size байт, по кругу в пределах footprint
+        STRIDE,        // stride: шаг stride байт
+        UNIFORM,       // uniform: равномерно случайные слова размера size
+        ZIPF,          // zipf: строки по stride байт, популярность по закону Ципфа с показателем alpha
+        POINTER_CHASE, // chase: один случайный цикл по всем строкам, как обход связного списка
+        MIXED          // mixed: вперемешку seq, uniform и zipf, по умолчанию 30% записей
+    };
+
+    struct WorkloadSpec {
+        WorkloadPattern pattern = WorkloadPattern::SEQUENTIAL;
+        uint64_t count = 1000000;
+        uint64_t base = 0;
+        uint64_t footprint = 1 << 20;
+        uint64_t stride = 64;
+        size_t size = 4;
+        double read_ratio = 1.0;
+        double alpha = 0.99;
+        uint64_t seed = 1;
+    };
+
+    // Целое десятичное или с 0x, с необязательным множителем K, M или G (степени 1024);
+    // key - для сообщения std::invalid_argument
+    uint64_t parse_amount(std::string_view key, std::string_view text);
+
+    // "pattern[:key=value]...", ключи count, base, footprint, stride, size, reads, alpha, seed;
+    // к числам можно приписать K, M или G. Ошибка - std::invalid_argument
+    WorkloadSpec parse_workload_spec(const std::string& text);
+
+    // Выборка ранга 1..n по закону Ципфа методом rejection-inversion
+    // (Hörmann, Derflinger): O(1) на выборку и никаких таблиц
+    class ZipfSampler {
+    private:
+        uint64_t _n = 1;
+        double _exponent = 1.0;
+        double _h_integral_x1 = 0;
+        double _h_integral_n = 0;
+        double _s = 0;
+
+        double h(double x) const;
+        double h_integral(double x) const;
+        double h_integral_inverse(double x) const;
+    public:
+        ZipfSampler() = default;
+        ZipfSampler(uint64_t n, double exponent);
+
+        uint64_t sample(XorShift& rng) const;
+    };
+
+    class WorkloadGenerator {
+    private:
+        WorkloadSpec _spec;
+        XorShift _rng;
+        uint64_t _words;       // слов размера size в footprint
+        uint64_t _lines;       // строк размера stride в footprint
+        uint64_t _sequential = 0;
+        uint64_t _line = 0;
+        uint64_t _scramble = 1; // разносит популярные строки Ципфа по всему footprint
+        ZipfSampler _zipf;
+        std::vector<uint32_t> _chain;
+
+        uint64_t next_sequential();
+        uint64_t next_address();
+        uint64_t zipf_line();
+        double uniform();
+    public:
+        explicit WorkloadGenerator(const WorkloadSpec& spec);
+
+        void next(InQuery& query);
+    };
+
+    // Прогоняет spec.count обращений пакетами через query_batch и печатает скорость
+    void run_workload(const WorkloadSpec& spec, MemoryHierarchy& hierarchy);
+
+}
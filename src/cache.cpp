@@ -1,264 +1,106 @@
-#include "../include/cache.hpp"
+#include "../include/cache_impl.hpp"
 
 
 namespace Cache{
-    void Cache::handle_write(CacheBlock& block, const Data& data) {
-        block.data = data;
-        block.dirty = (_write_policy == WritePolicy::WRITE_BACK);
+    void Cache::handle_write(size_t index, size_t way, const Data& data) {
+        size_t slot = _tag_store.slot(index, way);
+        if (_data_mode == DataMode::FULL) {
+            _tag_store.data[slot] = data;
+        }
+        _tag_store.dirty[slot] = (_write_policy == WritePolicy::WRITE_BACK);
         
         if (_write_policy == WritePolicy::WRITE_THROUGH) {
             OutQuery result;
-            uint64_t address = (block.tag << (_offset_bits + _index_bits)) | 
-                            (get_index(block.tag) << _offset_bits);
+            uint64_t address = (_tag_store.tags[slot] << (_offset_bits + _index_bits)) | 
+                            (index << _offset_bits);
             result.out.push_back({Operation::WRITE, address, data});
         }
     }
 
 
-    bool Cache::should_allocate(Operation op) const {
-        switch (_alloc_policy) {
-            case AllocationPolicy::READ_ALLOCATE: 
-                return op == Operation::READ;
-            case AllocationPolicy::WRITE_ALLOCATE:
-                return op == Operation::WRITE;
-            case AllocationPolicy::BOTH:
-                return true;
-            default:
-                return false;
+    void Cache::fill(uint64_t address, size_t way, const Data& block) {
+        if (_data_mode == DataMode::FULL) {
+            _tag_store.data[_tag_store.slot(get_index(address), way)] = make_block_data(block);
         }
     }
 
-    auto Cache::select_victim(CacheLine& line) -> std::list<CacheBlock>::iterator {
-        switch (_repl_policy) {
-            case ReplacementPolicy::LRU:
-                return std::prev(line.cache_line.end());
-            case ReplacementPolicy::MRU:
-                return line.cache_line.begin();
-            case ReplacementPolicy::RANDOM: {
-                size_t index = rand() % line.cache_line.size();
-                return std::next(line.cache_line.begin(), index);
-            }
-            default:
-                    return std::prev(line.cache_line.end());
-        }
+    size_t Cache::find_block(size_t index, uint64_t tag) const {
+        return find_block_impl(runtime_config(), index, tag);
     }
 
-    void Cache::add_block(CacheLine& line, uint64_t tag, Data data, OutQuery& result) {
-        size_t block_id = generate_block_id();
-        
-        if (line.count < _associativity) {
-            line.cache_line.emplace_front(block_id, tag, data);
-            line.count++;
-        } else {
-            auto lru_it = std::prev(line.cache_line.end());
-            CacheBlock& evicted_block = *lru_it;
-
-            result.evicted = true;
-            result.evicted_tag = evicted_block.tag;
-
-            if (evicted_block.dirty) {
-                uint64_t address = (evicted_block.tag << (_offset_bits + _index_bits)) | 
-                                (get_index(result.evicted_tag) << _offset_bits);
-                result.out.push_back({Operation::WRITE, address, evicted_block.data});
-            }
+    bool Cache::should_allocate(Operation op) const {
+        return should_allocate_impl(runtime_config(), op);
+    }
 
-            size_t old_id = evicted_block.id;
-            *lru_it = CacheBlock(old_id, true, tag, false, std::move(data));
-            move_beg_block(line, lru_it);
-        }
+    size_t Cache::select_victim(size_t index) {
+        return select_victim_impl(runtime_config(), index);
     }
 
     auto Cache::query(InQuery const& query) -> OutQuery {
         OutQuery result;
-        
-        size_t size_bytes = query.size;
-        size_t elements = (size_bytes + sizeof(int) - 1) / sizeof(int);
-        elements = std::min(elements, Data::SIZE);
-
-        uint64_t tag = get_tag(query.address);
-        uint64_t index = get_index(query.address);
-        uint64_t offset = get_offset(query.address);
-        auto& line = _tag_store[index];
-
-        auto block_it = find_block(line, tag);
-
-        if (block_it != line.cache_line.end()) { // Cache hit
-            result.hit = true;
-            
-            if (_repl_policy != ReplacementPolicy::RANDOM) {
-                move_beg_block(line, block_it);
-            }
+        query_impl(runtime_config(), query, result);
+        return result;
+    }
 
-            if (query.operation == Operation::READ) {
-                Data response;
-                size_t elements_to_read = std::min(elements, Data::SIZE - offset);
-                block_it->data.read_data(response.buffer.data(), elements_to_read, offset);
-                response.valid_count = elements_to_read;
-                result.returned_data = response;
-            } else { // WRITE
-                size_t elements_to_write = std::min(elements, Data::SIZE - offset);
-                block_it->data.write_data(query.data.buffer.data(), elements_to_write, offset);
-                block_it->dirty = (_write_policy == WritePolicy::WRITE_BACK);
-                
-                if (_write_policy == WritePolicy::WRITE_THROUGH) {
-                    result.out.emplace_back(InQuery{
-                        Operation::WRITE,
-                        query.address,
-                        block_it->data,
-                        query.size
-                    });
-                    block_it->dirty = false;
-                }
-            }
-        } else { // Cache miss
-            if (should_allocate(query.operation)) {
-                if (line.count >= _associativity) {
-                    auto victim_it = select_victim(line);
-                    result.evicted = true;
-                    result.evicted_tag = victim_it->id;
-                    
-                    if (victim_it->dirty) {
-                        if (_write_policy == WritePolicy::WRITE_BACK) {
-                            uint64_t evicted_addr = (victim_it->tag << (_offset_bits + _index_bits)) | 
-                                                (index << _offset_bits);
-                            result.out.emplace_back(InQuery{
-                                Operation::WRITE,
-                                evicted_addr,
-                                victim_it->data
-                            });
-                        }
-                    }
-                    
-                    // Заменяем блок
-                    victim_it->tag = tag;
-                    victim_it->data = query.operation == Operation::WRITE ? query.data : Data{};
-                    
-                    if (query.operation == Operation::READ) {
-                        victim_it->data.valid_count = Data::SIZE;
-                    }
-                                        
-                    *victim_it = CacheBlock(victim_it->id, true, tag, 
-                       (query.operation == Operation::WRITE) && 
-                       (_write_policy == WritePolicy::WRITE_BACK),
-                       query.operation == Operation::WRITE ? query.data : Data{});
-                    
-                    // Для WRITE_THROUGH при записи сразу отправляем в память
-                    if (query.operation == Operation::WRITE && 
-                        _write_policy == WritePolicy::WRITE_THROUGH) {
-                        victim_it->data = query.data;
-                        victim_it->data.valid_count = std::min(query.data.valid_count, Data::SIZE);
-                        
-                        result.out.emplace_back(InQuery{
-                            Operation::WRITE,
-                            query.address,
-                            query.data 
-                        });
-                        victim_it->dirty = false;
-                    }
-                    
-                    // Для чтения запрашиваем данные из памяти
-                    if (query.operation == Operation::READ) {
-                        result.out.emplace_back(InQuery{
-                            Operation::READ,
-                            query.address,
-                            {},
-                            Data::SIZE
-                        });
-                    }
-                    
-                    move_beg_block(line, victim_it);
-                } else {
-                    // Добавляем новый блок
-                    line.cache_line.emplace_front(generate_block_id(), tag, query.data);
-                    auto& new_block = line.cache_line.front();
-                    new_block.valid = true;
-                    new_block.data.valid_count = Data::SIZE;
-                    new_block.dirty = (query.operation == Operation::WRITE) && 
-                                    (_write_policy == WritePolicy::WRITE_BACK);
-                    line.count++;
+    void Cache::prefetch(uint64_t address) const {
+        prefetch_set(runtime_config(), get_index(address));
+    }
 
-                    if (query.operation == Operation::READ) {
-                        new_block.data.valid_count = Data::SIZE;
-                    }
-                    
-                    // Для WRITE_THROUGH при записи сразу отправляем в память
-                    if (query.operation == Operation::WRITE && 
-                        _write_policy == WritePolicy::WRITE_THROUGH) {
-                        result.out.emplace_back(InQuery{
-                            Operation::WRITE,
-                            query.address,
-                            new_block.data
-                        });
-                        new_block.dirty = false;
-                    }
-                    
-                    if (query.operation == Operation::READ) {
-                        result.out.emplace_back(InQuery{
-                            Operation::READ,
-                            query.address,
-                            {},
-                            Data::SIZE
-                        });
-                    }
-                }
-            } else {
-                //Прямая запись в память
-                if (query.operation == Operation::WRITE) {
-                    result.out.push_back(query);
-                } else {
-                    result.out.emplace_back(InQuery{
-                        Operation::READ,
-                        query.address,
-                        {},
-                        Data::SIZE
-                    });
-                }
-            }
-        }
-        
-        return result;
+    void Cache::query_batch(const InQuery* queries, size_t count, OutQuery* results) {
+        query_batch_impl(runtime_config(), queries, count, results);
     }
 
 
-    void Cache::print_cache_state(){
-        std::cout << "\nCache:\n";
+    void Cache::print_cache_state(std::ostream& out) {
+        out << "\nCache:\n";
         bool isEmpty = true;
         unsigned int total_blocks = 0;
         unsigned int dirty_blocks = 0;
 
-        for (const auto& [set_index, cache_line] : _tag_store) {
-            if (cache_line.cache_line.empty()) continue;
+        for (size_t set_index = 0; set_index < _tag_store.sets; ++set_index) {
+            unsigned int count = _tag_store.count[set_index];
+            if (count == 0) continue;
 
-            std::cout << "Set #" << set_index 
-                    << " [" << cache_line.count << "/" << _associativity << " blocks]:\n";
+            out << "Set #" << set_index 
+                    << " [" << count << "/" << _associativity << " blocks]:\n";
             
             int block_counter = 0;
-            for (const auto& cache_block : cache_line.cache_line) {
-                if (!cache_block.valid) continue;
+            for (unsigned int way = 0; way < count; ++way) {
+                size_t slot = _tag_store.slot(set_index, way);
+                if (!_tag_store.valid[slot]) continue;
                 
                 isEmpty = false;
                 total_blocks++;
-                if (cache_block.dirty) dirty_blocks++;
+                if (_tag_store.dirty[slot]) dirty_blocks++;
 
-                uint64_t full_address = (cache_block.tag << (_offset_bits + _index_bits)) | 
-                                    (set_index << _offset_bits);
+                uint64_t tag = _tag_store.tags[slot];
+                uint64_t full_address = block_address(set_index, tag);
 
-                std::cout << "  Block " << block_counter++
-                        << "    Tag: 0x" << std::hex << cache_block.tag  
+                out << "  Block " << block_counter++
+                        << "    Tag: 0x" << std::hex << tag  
                         << "    Address: 0x" << full_address  
-                        << "    State: " << (cache_block.dirty ? "Dirty" : "Clean")
-                        << "    Data: [";
+                        << "    State: " << (_tag_store.dirty[slot] ? "Dirty" : "Clean");
+
+                if (_data_mode == DataMode::TAGS_ONLY) {
+                    out << std::dec << "\n";
+                    continue;
+                }
+                out << "    Data: [";
                 
-                for (size_t i = 0; i < cache_block.data.valid_count; ++i) {
-                    if (i > 0) std::cout << ", ";
-                    std::cout << std::dec << cache_block.data[i];
+                const Data& block_data = _tag_store.data[slot];
+                for (size_t i = 0; i < block_data.valid_count; ++i) {
+                    if (i > 0) out << ", ";
+                    out << std::dec << block_data[i];
                 }
-                std::cout << "]\n";
+                out << "]\n";
             }
         }
 
         if (isEmpty) {
-            std::cout << "Cache is empty\n";
+            out << "Cache is empty\n";
+        }
+        if (_insertion) {
+            _insertion->print_state(out);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "memory.hpp"
+#include "sweep.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+using namespace Cache;
+namespace po = boost::program_options;
+
+// Перебор конфигураций кэша на одной трассе: трасса разбирается один раз,
+// конфигурации моделируются параллельно, по строке CSV на каждую
+namespace {
+    std::vector<std::string_view> split(std::string_view text) {
+        std::vector<std::string_view> items;
+        while (!text.empty()) {
+            size_t comma = text.find(',');
+            items.push_back(text.substr(0, comma));
+            text.remove_prefix(comma == std::string_view::npos ? text.size() : comma + 1);
+        }
+        return items;
+    }
+
+    template <typename T, typename Parse>
+    std::vector<T> parse_list(const po::variables_map& vm, const char* key, Parse parse) {
+        std::vector<T> values;
+        for (std::string_view item : split(vm[key].as<std::string>())) {
+            values.push_back(static_cast<T>(parse(item)));
+        }
+        if (values.empty()) throw std::invalid_argument(std::string("Empty list for --") + key);
+        return values;
+    }
+
+    SweepGrid make_grid(const po::variables_map& vm) {
+        auto amount = [](const char* key) {
+            return [key](std::string_view item) { return parse_amount(key, item); };
+        };
+        SweepGrid grid;
+        grid.sizes = parse_list<size_t>(vm, "sizes", amount("sizes"));
+        grid.block_sizes = parse_list<uint64_t>(vm, "blocks", amount("blocks"));
+        grid.associativities = parse_list<size_t>(vm, "ways", amount("ways"));
+        grid.write_policies = parse_list<WritePolicy>(vm, "write", parse_write_policy);
+        grid.alloc_policies = parse_list<AllocationPolicy>(vm, "alloc", parse_alloc_policy);
+        grid.replacements = parse_list<ReplacementPolicy>(vm, "replacement", parse_replacement_policy);
+        grid.levels = parse_list<size_t>(vm, "levels", amount("levels"));
+        grid.l2_sizes = parse_list<size_t>(vm, "l2-sizes", amount("l2-sizes"));
+        grid.l2_associativities = parse_list<size_t>(vm, "l2-ways", amount("l2-ways"));
+        grid.address_bits = vm["address-bits"].as<uint64_t>();
+        return grid;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    po::options_description desc("Cache Sweep Options");
+    desc.add_options()
+        ("help,h", "Show help message")
+        ("test", po::value<std::string>(), "Trace file")
+        ("format", po::value<std::string>()->default_value("native"), "Trace format (native, din, lackey, champsim)")
+        ("gen", po::value<std::string>(), "Synthetic workload instead of a trace, as in model1 --gen")
+        ("sizes", po::value<std::string>()->default_value("4K,16K,64K"), "L1 sizes")
+        ("blocks", po::value<std::string>()->default_value("32,64"), "Block sizes")
+        ("ways", po::value<std::string>()->default_value("1,2,4,8"), "L1 associativities")
+        ("write", po::value<std::string>()->default_value("wb"), "Write policies (wb, wt)")
+        ("alloc", po::value<std::string>()->default_value("read"), "Allocation policies (read, write, both)")
+        ("replacement", po::value<std::string>()->default_value("lru"),
+         "Replacement policies (lru, mru, random, plru, nru, srrip, brrip)")
+        ("levels", po::value<std::string>()->default_value("1"), "Numbers of cache levels (1, 2)")
+        ("l2-sizes", po::value<std::string>()->default_value("256K"), "L2 sizes for two-level configurations")
+        ("l2-ways", po::value<std::string>()->default_value("8"), "L2 associativities")
+        ("address-bits", po::value<uint64_t>()->default_value(48), "Address width")
+        ("threads,j", po::value<size_t>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+         "Worker threads")
+        ("output,o", po::value<std::string>(), "CSV file (default stdout)");
+
+    po::variables_map vm;
+    try {
+        vm = parse_command_line_args(argc, argv, desc);
+    } catch (const po::error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (handle_help_option(vm, desc)) {
+        return 0;
+    }
+    if (vm.count("test") == vm.count("gen")) {
+        std::cerr << "Error: exactly one of --test and --gen is required" << std::endl;
+        return 1;
+    }
+
+    std::vector<SweepConfig> configs;
+    std::vector<SweepAccess> trace;
+    SweepGrid grid;
+    try {
+        grid = make_grid(vm);
+        configs = grid.expand();
+        auto start = std::chrono::steady_clock::now();
+        trace = vm.count("gen") ? load_sweep_trace(parse_workload_spec(vm["gen"].as<std::string>()))
+                                : load_sweep_trace(vm["test"].as<std::string>(), get_trace_format(vm));
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << trace.size() << " accesses loaded in " << elapsed.count() << " s, "
+                  << configs.size() << " configurations" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    size_t threads = vm["threads"].as<size_t>();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results = run_sweep(configs, grid.address_bits, trace, threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "Simulated in " << elapsed.count() << " s on " << threads << " threads" << std::endl;
+
+    if (vm.count("output")) {
+        std::ofstream out(vm["output"].as<std::string>());
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open output file: " << vm["output"].as<std::string>() << std::endl;
+            return 1;
+        }
+        write_sweep_csv(out, results);
+    } else {
+        write_sweep_csv(std::cout, results);
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "../include/event_trace.hpp"
+#include "../include/report.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace Cache {
+    namespace {
+        constexpr auto WRITER_IDLE = std::chrono::microseconds(200);
+
+        std::atomic<uint64_t> next_log_id{1};
+    }
+
+    thread_local EventLog::Local EventLog::_local;
+
+    EventLog::EventLog(const std::string& path)
+        : _id(next_log_id.fetch_add(1, std::memory_order_relaxed)), _file(path, std::ios::binary) {
+        if (!_file.is_open()) {
+            throw std::runtime_error("Cannot open event log: " + path);
+        }
+        uint32_t header[2] = {FILE_VERSION, static_cast<uint32_t>(sizeof(TraceEvent))};
+        _file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        _file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        _writer = std::thread(&EventLog::write_blocks, this);
+    }
+
+    EventLog::~EventLog() {
+        close();
+    }
+
+    // Поток, который уже писал в этот журнал, получает своё прежнее кольцо
+    EventLog::Producer& EventLog::attach() {
+        std::lock_guard<std::mutex> lock(_producers_mutex);
+        auto self = std::this_thread::get_id();
+        auto it = std::find_if(_producers.begin(), _producers.end(),
+                               [&](const auto& producer) { return producer->owner == self; });
+        Producer* producer = nullptr;
+        if (it != _producers.end()) {
+            producer = it->get();
+        } else {
+            _producers.push_back(std::make_unique<Producer>());
+            producer = _producers.back().get();
+            producer->owner = self;
+            producer->thread = static_cast<uint32_t>(_producers.size() - 1);
+            producer->block = &producer->ring.acquire();
+            producer->block->count = 0;
+            _published_producers.store(_producers.size(), std::memory_order_release);
+        }
+        _local.log = _id;
+        _local.producer = producer;
+        return *producer;
+    }
+
+    void EventLog::write_blocks() {
+        std::vector<Producer*> producers;
+        for (;;) {
+            // Флаг читается до колец: всё, что опубликовано до close, будет забрано в этом проходе
+            bool closing = _closing.load(std::memory_order_acquire);
+            if (producers.size() != _published_producers.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(_producers_mutex);
+                producers.clear();
+                for (const auto& producer : _producers) producers.push_back(producer.get());
+            }
+
+            bool wrote = false;
+            for (Producer* producer : producers) {
+                while (Block* block = producer->ring.try_front()) {
+                    uint32_t header[2] = {producer->thread, block->count};
+                    _file.write(reinterpret_cast<const char*>(header), sizeof(header));
+                    _file.write(reinterpret_cast<const char*>(block->events.data()),
+                                static_cast<std::streamsize>(block->count * sizeof(TraceEvent)));
+                    producer->ring.release();
+                    wrote = true;
+                }
+            }
+            if (!wrote) {
+                if (closing) return;
+                std::this_thread::sleep_for(WRITER_IDLE);
+            }
+        }
+    }
+
+    void EventLog::close() {
+        if (_closed) return;
+        _closed = true;
+        {
+            std::lock_guard<std::mutex> lock(_producers_mutex);
+            for (auto& producer : _producers) {
+                if (producer->block->count > 0) producer->ring.commit();
+                producer->block = nullptr;
+            }
+        }
+        _closing.store(true, std::memory_order_release);
+        _writer.join();
+        _file.close();
+    }
+
+    EventLogReader::EventLogReader(const std::string& path) : _in(path, std::ios::binary) {
+        if (!_in.is_open()) {
+            throw std::runtime_error("Cannot open event log: " + path);
+        }
+        char magic[sizeof(EventLog::FILE_MAGIC)];
+        uint32_t header[2];
+        _in.read(magic, sizeof(magic));
+        _in.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!_in || std::memcmp(magic, EventLog::FILE_MAGIC, sizeof(magic)) != 0) {
+            throw std::runtime_error("Not an event log: " + path);
+        }
+        if (header[0] != EventLog::FILE_VERSION || header[1] != sizeof(TraceEvent)) {
+            throw std::runtime_error("Unsupported event log version: " + path);
+        }
+    }
+
+    bool EventLogReader::next(uint32_t& thread, TraceEvent& event) {
+        while (_next == _block.size()) {
+            uint32_t header[2];
+            if (!_in.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+            if (header[1] > EventLog::BLOCK_EVENTS) {
+                throw std::runtime_error("Corrupted event log block");
+            }
+            _thread = header[0];
+            _block.resize(header[1]);
+            _next = 0;
+            if (!_in.read(reinterpret_cast<char*>(_block.data()),
+                          static_cast<std::streamsize>(_block.size() * sizeof(TraceEvent)))) {
+                throw std::runtime_error("Truncated event log");
+            }
+        }
+        thread = _thread;
+        event = _block[_next++];
+        return true;
+    }
+
+    void report_event(ReportSink& report, const TraceEvent& event, TraceLevel level) {
+        InQuery query{static_cast<Operation>(event.operation), event.address, Data{}, event.size};
+        if (event.level == TraceEvent::MEMORY_LEVEL) {
+            if (level < TraceLevel::FULL) return;
+            size_t elements = std::min((event.size + sizeof(int) - 1) / sizeof(int), Data::SIZE);
+            report.memory_access(query, elements, nullptr, 0);
+            return;
+        }
+        OutQuery result;
+        result.hit = event.flags & TraceEvent::HIT;
+        result.evicted = event.flags & TraceEvent::EVICTED;
+        result.evicted_tag = event.evicted_tag;
+        report.access(event.level, query, result, level >= TraceLevel::FULL);
+    }
+}
@@ -205,8 +205,27 @@ void test_hierarchy(std::shared_ptr<MemoryHierarchy> hierarchy) {
     hierarchy->print_caches_state();
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    auto desc = create_options_description();
+    auto vm = parse_command_line_args(argc, argv, desc);
+
+    if (handle_help_option(vm, desc)) {
+        return 0;
+    }
+
+    // С --gen каждая конфигурация прогоняет синтетическую нагрузку вместо демонстрации
+    auto run = [&](std::shared_ptr<MemoryHierarchy> hierarchy) {
+        if (vm.count("gen")) {
+            run_workload(get_workload_spec(vm), *hierarchy);
+            hierarchy->print_stats();
+        } else {
+            test_hierarchy(hierarchy);
+        }
+    };
+
     auto memory = std::make_shared<MemoryModel>();
+    memory->set_report(std::make_shared<ReportSink>(std::cout, get_output_format(vm)));
+    map_memory_images(*memory, vm);
 
     {
         std::cout << "\n\n2xWRITE-BACK,READ-ALLOCATE,LRU\n";
@@ -226,7 +245,7 @@ int main() {
         
         auto hierarchy = std::make_shared<MemoryHierarchy>(caches, memory);
         
-        test_hierarchy(hierarchy);
+        run(hierarchy);
     }
 
     {
@@ -247,7 +266,7 @@ int main() {
         
         auto hierarchy = std::make_shared<MemoryHierarchy>(caches, memory);
         
-        test_hierarchy(hierarchy);
+        run(hierarchy);
     }
 
     {
@@ -268,7 +287,7 @@ int main() {
         
         auto hierarchy = std::make_shared<MemoryHierarchy>(caches, memory);
         
-        test_hierarchy(hierarchy);
+        run(hierarchy);
     }
 
     return 0;
@@ -1,27 +1,192 @@
 #include "../include/memory.hpp"
+#include "../include/pipeline.hpp"
+#include "../include/static_cache.hpp"
+#include "../include/trace.hpp"
+#include "../include/trace_import.hpp"
+#include <algorithm>
 #include <fstream>
 
 namespace Cache {
+    // Страницы заводятся лениво, поэтому инициализация только запоминает режим
     void MemoryModel::initialize(MemoryInitMode mode) {
-        _memory.clear();
-        Data zero_data;
-        zero_data.valid_count = Data::SIZE;
-        std::fill(zero_data.buffer.begin(), zero_data.buffer.end(), 0);
-
-        if (mode == MemoryInitMode::ADDRESSES) {
-            for (uint64_t addr = 0; addr < 0x1000; addr += Data::SIZE * sizeof(int)) { 
-                Data d;
-                for (size_t i = 0; i < Data::SIZE; ++i) {
-                    d[i] = static_cast<int>(addr + i * sizeof(int));
-                }
-                d.valid_count = Data::SIZE;
-                _memory[addr] = d;
+        _pages.clear();
+        _init_mode = mode;
+        // Изменения в образах переживают сброс страниц
+        _changed_pages.erase(std::remove_if(_changed_pages.begin(), _changed_pages.end(),
+                                            [&](uint64_t number) { return !find_image(number << PAGE_BITS); }),
+                             _changed_pages.end());
+    }
+
+    Page& MemoryModel::materialize(uint64_t address) {
+        bool inserted = false;
+        uint64_t number = PageTable::page_number(address);
+        Page& page = *_pages.insert(number, inserted);
+        if (inserted) {
+            uint64_t base = number << PAGE_BITS;
+            for (size_t i = 0; i < PAGE_WORDS; ++i) page.words[i] = virtual_word(base + i * sizeof(int));
+            page.written_blocks = 0;
+            page.changed_blocks = 0;
+        }
+        return page;
+    }
+
+    MemoryImageSpec parse_memory_image(std::string_view text) {
+        size_t at = text.rfind('@');
+        if (at == std::string_view::npos || at == 0 || at + 1 == text.size()) {
+            throw std::invalid_argument("Memory image must be path@base: " + std::string(text));
+        }
+        std::string base(text.substr(at + 1));
+        size_t parsed = 0;
+        uint64_t value = 0;
+        try {
+            value = std::stoull(base, &parsed, 0);
+        } catch (const std::exception&) {
+            parsed = 0;
+        }
+        if (parsed != base.size()) {
+            throw std::invalid_argument("Bad memory image base: " + base);
+        }
+        return {std::string(text.substr(0, at)), value};
+    }
+
+    void MemoryModel::map_image(const std::string& path, uint64_t base) {
+        if (base & (PAGE_SIZE - 1)) {
+            throw std::invalid_argument("Memory image base must be 4 KB aligned: " + path);
+        }
+        auto file = std::make_unique<MappedFile>(path, MapAccess::COPY_ON_WRITE);
+        if (file->size() == 0) {
+            throw std::invalid_argument("Memory image is empty: " + path);
+        }
+        // Хвост последней страницы за концом файла отображение читает нулями
+        uint64_t pages = (file->size() + PAGE_SIZE - 1) / PAGE_SIZE;
+        uint64_t end = base + pages * PAGE_SIZE;
+        for (const auto& image : _images) {
+            if (base < image.end && image.base < end) {
+                throw std::invalid_argument("Memory image " + path + " overlaps " + image.path);
+            }
+        }
+        Image image{base, end, path, std::move(file), std::vector<uint64_t>(pages, 0), std::vector<uint64_t>(pages, 0)};
+        auto pos = std::upper_bound(_images.begin(), _images.end(), base,
+                                    [](uint64_t address, const Image& other) { return address < other.base; });
+        _images.insert(pos, std::move(image));
+    }
+
+    const MemoryModel::Image* MemoryModel::find_image(uint64_t address) const {
+        auto pos = std::upper_bound(_images.begin(), _images.end(), address,
+                                    [](uint64_t value, const Image& image) { return value < image.base; });
+        if (pos == _images.begin()) return nullptr;
+        --pos;
+        return address < pos->end ? &*pos : nullptr;
+    }
+
+    const int* MemoryModel::find_block(uint64_t aligned_addr) const {
+        if (!_images.empty()) {
+            if (const Image* image = find_image(aligned_addr)) {
+                return reinterpret_cast<const int*>(image->file->data() + (aligned_addr - image->base));
             }
+        }
+        const Page* page = _pages.find(PageTable::page_number(aligned_addr));
+        return page ? page->words.data() + (aligned_addr & (PAGE_SIZE - 1)) / sizeof(int) : nullptr;
+    }
+
+    int* MemoryModel::writable_block(uint64_t aligned_addr) {
+        uint64_t number = PageTable::page_number(aligned_addr);
+        uint64_t bit = uint64_t{1} << ((aligned_addr & (PAGE_SIZE - 1)) / BLOCK_BYTES);
+        uint64_t* written;
+        uint64_t* changed;
+        int* words;
+        const Image* found = _images.empty() ? nullptr : find_image(aligned_addr);
+        if (found) {
+            Image& image = _images[found - _images.data()];
+            uint64_t offset = aligned_addr - image.base;
+            written = &image.written_blocks[offset / PAGE_SIZE];
+            changed = &image.changed_blocks[offset / PAGE_SIZE];
+            if (*written == 0) ++image.dirty_count;
+            words = reinterpret_cast<int*>(image.file->mutable_data() + offset);
+        } else {
+            Page& page = materialize(aligned_addr);
+            written = &page.written_blocks;
+            changed = &page.changed_blocks;
+            words = page.words.data() + (aligned_addr & (PAGE_SIZE - 1)) / sizeof(int);
+        }
+        if (*changed == 0) _changed_pages.push_back(number);
+        *written |= bit;
+        *changed |= bit;
+        return words;
+    }
+
+    uint64_t* MemoryModel::block_masks(uint64_t number, bool changed) {
+        if (const Image* found = _images.empty() ? nullptr : find_image(number << PAGE_BITS)) {
+            Image& image = _images[found - _images.data()];
+            uint64_t index = ((number << PAGE_BITS) - image.base) / PAGE_SIZE;
+            return changed ? &image.changed_blocks[index] : &image.written_blocks[index];
+        }
+        Page* page = _pages.find(number);
+        if (!page) return nullptr;
+        return changed ? &page->changed_blocks : &page->written_blocks;
+    }
+
+    void MemoryModel::read_block(uint64_t aligned_addr, Data& block) const {
+        if (const int* words = find_block(aligned_addr)) {
+            std::copy_n(words, Data::SIZE, block.buffer.begin());
         } else {
-            for (uint64_t addr = 0; addr < 0x1000; addr += Data::SIZE * sizeof(int)) {
-                _memory[addr] = zero_data;
+            for (size_t i = 0; i < Data::SIZE; ++i) block.buffer[i] = virtual_word(aligned_addr + i * sizeof(int));
+        }
+        block.valid_count = Data::SIZE;
+    }
+
+    void MemoryModel::print_images() const {
+        if (_images.empty()) return;
+        std::ostream& out = _report->text();
+        for (const auto& image : _images) {
+            out << "Image " << image.path << " at 0x" << std::hex << image.base << std::dec
+                << ": " << image.file->size() << " bytes, " << image.dirty_count << " of "
+                << image.written_blocks.size() << " pages modified\n";
+        }
+    }
+
+    void MemoryModel::print_blocks(uint64_t number, uint64_t mask) const {
+        Data block;
+        for (; mask; mask &= mask - 1) {
+            uint64_t address = (number << PAGE_BITS) + static_cast<uint64_t>(__builtin_ctzll(mask)) * BLOCK_BYTES;
+            read_block(address, block);
+            _report->memory_block(address, block);
+        }
+    }
+
+    void MemoryModel::print_modified_memory() {
+        // Страницы из PageTable уже по порядку; образы не пересекаются с ними и между собой
+        std::vector<uint64_t> numbers;
+        _pages.for_each([&](uint64_t number, const Page& page) {
+            if (page.written_blocks) numbers.push_back(number);
+        });
+        for (const auto& image : _images) {
+            for (size_t i = 0; i < image.written_blocks.size(); ++i) {
+                if (image.written_blocks[i]) numbers.push_back((image.base >> PAGE_BITS) + i);
             }
         }
+        if (numbers.empty()) {
+            return;
+        }
+        std::sort(numbers.begin(), numbers.end());
+
+        _report->begin_blocks("Modified Memory Contents");
+        for (uint64_t number : numbers) print_blocks(number, *block_masks(number, false));
+    }
+
+    void MemoryModel::print_memory_changes() {
+        if (_changed_pages.empty()) {
+            return;
+        }
+        std::sort(_changed_pages.begin(), _changed_pages.end());
+
+        _report->begin_blocks("Modified Memory Contents");
+        for (uint64_t number : _changed_pages) {
+            uint64_t* changed = block_masks(number, true);
+            print_blocks(number, *changed);
+            *changed = 0;
+        }
+        _changed_pages.clear();
     }
 
     OutQuery MemoryModel::query(const InQuery& in) {
@@ -33,188 +198,188 @@ namespace Cache {
         elements = std::min(elements, Data::SIZE); 
 
         uint64_t aligned_addr = in.address & ~(Data::SIZE * sizeof(int) - 1);
+        size_t offset = (in.address - aligned_addr) / sizeof(int); // номер элемента в строке памяти
         
-        if (_trace_level >= TraceLevel::FULL) {
-            std::cout << "MEM: " << (in.operation == Operation::READ ? "READ" : "WRITE")
-                    << " addr=0x" << std::hex << in.address << std::dec
-                    << " size_bits=" << in.size 
-                    << " (" << elements << " elements)" << std::endl;
+        if constexpr (COMPILED_TRACE_LEVEL >= TraceLevel::FULL) {
+            if (_events) _events->record(TraceEvent::MEMORY_LEVEL, in.operation, in.address, in.size, true, false, 0);
+            if (_trace_level >= TraceLevel::FULL) {
+                // Записанные данные выводятся только когда память их хранит
+                bool with_data = in.operation == Operation::WRITE && _data_mode == DataMode::FULL;
+                _report->memory_access(in, elements, with_data ? in.data.buffer.data() : nullptr,
+                                       std::min(elements, Data::SIZE - offset));
+            }
+        }
+
+        ++(in.operation == Operation::READ ? _stats.reads : _stats.writes);
+
+        if (_data_mode == DataMode::TAGS_ONLY) {
+            return result;
         }
 
         if (in.operation == Operation::READ) {
-            if (_memory.count(aligned_addr)) {
-                Data& stored_data = _memory[aligned_addr];
-                Data response;
-                size_t elements_to_read = std::min(elements, stored_data.valid_count);
-                stored_data.read_data(response.buffer.data(), elements_to_read);
-                response.valid_count = elements_to_read;
-                result.returned_data = response;
-            }
+            Data block;
+            read_block(aligned_addr, block);
+            Data response;
+            size_t elements_to_read = std::min(elements, Data::SIZE - offset);
+            block.read_data(response.buffer.data(), elements_to_read, offset);
+            response.valid_count = elements_to_read;
+            result.returned_data = response;
         } else { // WRITE
-            mark_modified(aligned_addr);
-            
-            Data& target = _memory[aligned_addr];
-            size_t elements_to_write = std::min(elements, Data::SIZE);
-            target.write_data(in.data.buffer.data(), elements_to_write);
-            target.valid_count = elements_to_write;
-            
-            if (_trace_level >= TraceLevel::FULL) {
-                std::cout << "MEM: WRITE data=[";
-                for (size_t i = 0; i < elements_to_write; ++i) {
-                    std::cout << in.data[i];
-                    if (i < elements_to_write - 1) std::cout << ", ";
-                }
-                std::cout << "]" << std::endl;
-            }
+            size_t elements_to_write = std::min(elements, Data::SIZE - offset);
+            std::copy_n(in.data.buffer.data(), elements_to_write, writable_block(aligned_addr) + offset);
         }
         return result;
     }
 
     void MemoryHierarchy::log_query(size_t level, const InQuery& query, const OutQuery& result) {
-        if (_trace_level == TraceLevel::NONE) return;
-        
-        std::cout << "L" << level << ": " 
-                << (query.operation == Operation::READ ? "READ" : "WRITE")
-                << " addr=0x" << std::hex << query.address << std::dec
-                << " size=" << query.size
-                << " - " << (result.hit ? "HIT" : "MISS");
-        
-        if (_trace_level >= TraceLevel::FULL) {
-            if (result.returned_data) {
-                std::cout << " data=[";
-                for (size_t i = 0; i < result.returned_data->valid_count; ++i) {
-                    std::cout << (*result.returned_data)[i];
-                    if (i < result.returned_data->valid_count - 1) std::cout << ", ";
-                }
-                std::cout << "]";
-            }
-            if (result.evicted) {
-                std::cout << " evicted=0x" << std::hex << result.evicted_tag << std::dec;
+        if constexpr (COMPILED_TRACE_LEVEL != TraceLevel::NONE) {
+            if (EventLog* events = _memory->events()) {
+                events->record(static_cast<uint8_t>(level), query.operation, query.address, query.size,
+                               result.hit, result.evicted, result.evicted_tag);
             }
+            if (_trace_level == TraceLevel::NONE) return;
+            report().access(level, query, result, _trace_level >= TraceLevel::FULL);
         }
-        std::cout << std::endl;
     }
 
 
+    // Только заведённые страницы, по возрастанию адреса
     void MemoryModel::print_memory() {
-        if (_memory.empty()) {
-            std::cout << "Memory is empty" << std::endl;
+        if (_pages.pages() == 0) {
+            _report->text() << "Memory is empty\n";
             return;
         }
 
-        std::cout << "\nMemory Contents" << std::endl << "Address | Data" << std::endl;
+        _report->begin_blocks("Memory Contents");
+        _pages.for_each([&](uint64_t number, const Page&) { print_blocks(number, ~uint64_t{0}); });
+    }
+
+    OutQuery MemoryHierarchy::query(const InQuery& query) {
+        OutQuery final_result;
+        query_into(query, final_result);
+        return final_result;
+    }
 
-        for (const auto& [address, data] : _memory) {
-            std::cout << "0x" << std::hex << std::setw(8) << std::setfill('0') << address << " | ";
+    void MemoryHierarchy::query_into(const InQuery& query, OutQuery& final_result) {
+        if constexpr (COMPILED_TRACE_LEVEL != TraceLevel::NONE) {
+            if (EventLog* events = _memory->events()) events->next_request();
+        }
+        resolve(0, query, final_result);
+    }
 
-            if (data.valid_count == 0) {
-                std::cout << "<empty>";
-            } else {
-                for (size_t i = 0; i < data.valid_count; ++i) {
-                    std::cout << std::dec << data[i];
-                    if (i < data.valid_count - 1) {
-                        std::cout << ", ";
-                    }
+    // Каждый уровень видит только настоящие запросы к нему: промах уровня отдаёт
+    // свои запросы out следующему уровню, тот разрешает собственный промах так же,
+    // вплоть до памяти, а пришедший блок на обратном пути кладётся в путь,
+    // занятый при промахе
+    void MemoryHierarchy::resolve(size_t level, const InQuery& query, OutQuery& result) {
+        if (level == _caches.size()) {
+            result = _memory->query(query);
+            return;
+        }
+        Cache& cache = *_caches[level];
+        result = cache.query(query);
+        log_query(level, query, result);
+
+        if (!result.hit && !cache.should_allocate(query.operation)) {
+            // Уровень без заведения блока пропускает запрос ниже как есть
+            resolve(level + 1, query, result);
+            return;
+        }
+
+        // Запись вытесненного блока, подкачка блока и сквозная запись - по порядку out
+        const bool missed = !result.hit;
+        for (const InQuery& request : result.out) {
+            OutQuery next;
+            resolve(level + 1, request, next);
+            if (!missed || request.operation != Operation::READ) continue;
+
+            if (next.returned_data) {
+                // Блок пришёл целиком с начала; записанное при промахе остаётся поверх него
+                Data block = *next.returned_data;
+                size_t offset = cache.get_offset(query.address) / sizeof(int);
+                size_t elements = std::min((query.size + sizeof(int) - 1) / sizeof(int), Data::SIZE - offset);
+                if (query.operation == Operation::WRITE) {
+                    block.write_data(query.data.buffer.data(), elements, offset);
+                }
+                cache.fill(query.address, result.fill_way, block);
+
+                if (query.operation == Operation::READ) {
+                    Data response;
+                    size_t elements_to_read = std::min(elements, block.valid_count > offset ? block.valid_count - offset : 0);
+                    block.read_data(response.buffer.data(), elements_to_read, offset);
+                    response.valid_count = elements_to_read;
+                    result.returned_data = response;
                 }
             }
-            std::cout << std::endl;
+            // Чтение обслужено нижним уровнем; попадания самого уровня - в его статистике
+            if (query.operation == Operation::READ) result.hit = true;
         }
     }
 
-    OutQuery MemoryHierarchy::query(const InQuery& query) {
-        OutQuery final_result;
-        bool request_completed = false;
-        
-        for (size_t level = 0; level < _caches.size() && !request_completed; ++level) {
-            auto& cache = _caches[level];
-            OutQuery cache_result = cache->query(query);
+    void MemoryHierarchy::query_batch(const InQuery* queries, size_t count, OutQuery* results) {
+        const Cache* first = !_caches.empty() && _caches.front()->prefetch_useful() ? _caches.front().get() : nullptr;
+        for (size_t i = 0; i < count; ++i) {
+            if (first && i + BATCH_PREFETCH_DISTANCE < count) {
+                first->prefetch(queries[i + BATCH_PREFETCH_DISTANCE].address);
+            }
+            results[i].reset();
+            query_into(queries[i], results[i]);
+        }
+    }
 
-            log_query(level, query, cache_result);
-            
-            if (query.operation == Operation::WRITE && 
-                cache->get_write_policy() == WritePolicy::WRITE_THROUGH &&
-                cache_result.hit) {
-                for (auto& mem_query : cache_result.out) {
-                    if (level + 1 < _caches.size()) {
-                        _caches[level+1]->query(mem_query);
-                    } else {
-                        _memory->query(mem_query);
+    // В структурированных форматах - по событию на действительный блок каждого уровня
+    void MemoryHierarchy::print_caches_state() {
+        ReportSink& out = report();
+        if (out.structured()) {
+            for (size_t level = 0; level < _caches.size(); ++level) {
+                auto& cache = _caches[level];
+                const TagStore& store = cache->get_tag_store();
+                for (size_t set = 0; set < store.sets; ++set) {
+                    for (size_t way = 0; way < store.count[set]; ++way) {
+                        size_t slot = store.slot(set, way);
+                        if (!store.valid[slot]) continue;
+                        const Data* data = store.data.empty() ? nullptr : &store.data[slot];
+                        out.cache_block(level, set, way, store.tags[slot], cache->block_address(set, store.tags[slot]),
+                                        store.dirty[slot], data);
                     }
                 }
-                final_result = cache_result;
-                request_completed = true;
-                continue;
             }
+        } else if (out.enabled()) {
+            std::ostream& text = out.text();
+            for (auto& cache : _caches) {
+                cache->print_cache_state(text);
+            }
+        }
+        _memory->print_modified_memory();
+        out.flush();
+    }
 
-            if (cache_result.hit) {
-                final_result = cache_result;
-                request_completed = true;
-            } else {
-                if (cache->should_allocate(query.operation)) {
-                    for (auto& mem_query : cache_result.out) {
-                        OutQuery next_result;
-                        if (level + 1 < _caches.size()) {
-                            next_result = _caches[level+1]->query(mem_query);
-                        } else {
-                            next_result = _memory->query(mem_query);
-                        }
-
-                        if (query.operation == Operation::READ && next_result.returned_data) {
-                            uint64_t block_mask = ~(16 - 1);
-                            uint64_t aligned_addr = query.address & block_mask;
-                            
-                            InQuery update_query{
-                                Operation::WRITE,
-                                aligned_addr,
-                                *next_result.returned_data,
-                                16
-                            };
-                            
-                            cache->query(update_query);
-                            
-                            Data response_data;
-                            size_t offset = query.address - aligned_addr;
-                            size_t elements_to_read = std::min(
-                                (query.size + sizeof(int) - 1) / sizeof(int),
-                                Data::SIZE - offset / sizeof(int)
-                            );
-                            
-                            next_result.returned_data->read_data(
-                                response_data.buffer.data(),
-                                elements_to_read,
-                                offset / sizeof(int)
-                            );
-                            response_data.valid_count = elements_to_read;
-                            
-                            final_result.returned_data = response_data;
-                            final_result.hit = true;
-                            request_completed = true;
-                        }
-                    }
-                } else {
-                   
-                    if (level + 1 < _caches.size()) {
-                        final_result = _caches[level+1]->query(query);
-                    } else {
-                        final_result = _memory->query(query);
-                    }
-                    request_completed = true;
-                }
+    // Итоговая статистика выводится и при OutputFormat::NONE
+    void MemoryHierarchy::print_stats(bool per_set) {
+        ReportSink& out = report();
+        if (out.structured()) {
+            for (size_t level = 0; level < _caches.size(); ++level) {
+                out.cache_stats("L" + std::to_string(level), _caches[level]->get_stats());
             }
+            out.memory_stats(_memory->get_stats());
+            out.flush();
+            return;
         }
-        if (!request_completed) {
-            final_result = _memory->query(query);
+        std::ostream& text = out.text();
+        text << "\nStatistics\n";
+        for (size_t level = 0; level < _caches.size(); ++level) {
+            _caches[level]->get_stats().print(text, "L" + std::to_string(level), per_set);
         }
-        
-        return final_result;
+        _memory->get_stats().print(text);
+        _memory->print_images();
+        out.flush();
     }
 
-
-    void MemoryHierarchy::print_caches_state() {
-        for(auto cache: _caches) {
-            cache->print_cache_state();
+    void MemoryHierarchy::reset_stats() {
+        for (auto& cache : _caches) {
+            cache->reset_stats();
         }
-        _memory->print_modified_memory();
+        _memory->reset_stats();
     }
 
     void MemoryHierarchy::update_cache_level(size_t level, uint64_t address, const Data& data) {
@@ -225,10 +390,8 @@ namespace Cache {
         } else {
             uint64_t tag = cache->get_tag(address);
             uint64_t index = cache->get_index(address);
-            auto& line = cache->get_tag_store()[index];
-            auto block_it = cache->find_block(line, tag);
             
-            if (block_it != line.cache_line.end()) {
+            if (cache->find_block(index, tag) != Cache::npos) {
                 InQuery update{Operation::WRITE, address, data};
                 cache->query(update);
             }
@@ -241,176 +404,192 @@ namespace Cache {
         }
     }
 
-    void run_tests(const std::string& test_file, std::shared_ptr<MemoryHierarchy> hierarchy) {
-        std::ifstream infile(test_file);
-        if (!infile.is_open()) {
-            std::cerr << "Error: Cannot open test file: " << test_file << std::endl;
-            exit(1);
+    namespace {
+        std::shared_ptr<MemoryHierarchy> make_hierarchy(std::vector<std::shared_ptr<Cache>> caches,
+                                                        std::shared_ptr<MemoryModel> memory, TraceLevel trace,
+                                                        DataMode data_mode, InsertionPolicy insertion) {
+            for (size_t level = 0; level < caches.size(); ++level) {
+                size_t sets = caches[level]->get_tag_store().sets;
+                if (!InsertionController::supports(insertion, sets)) {
+                    // Полностью ассоциативный L2 model2: лидерам и ведомым не хватает наборов
+                    std::cerr << "L" << level << ": adaptive insertion needs at least "
+                              << InsertionController::MIN_ADAPTIVE_SETS << " sets, using normal" << std::endl;
+                    continue;
+                }
+                caches[level]->set_insertion_policy(insertion);
+            }
+            return std::make_shared<MemoryHierarchy>(std::move(caches), std::move(memory), trace, data_mode);
         }
-        std::string line;
-        
-        while (std::getline(infile, line)) {
-            std::istringstream iss(line);
-            std::string op;
+    }
 
-            if (line.empty() || std::all_of(line.begin(), line.end(), ::isspace)) {
-            continue;
-        }
+    std::shared_ptr<MemoryHierarchy> make_model1_hierarchy(std::shared_ptr<MemoryModel> memory, TraceLevel trace,
+                                                           DataMode data_mode, InsertionPolicy insertion) {
+        std::vector<std::shared_ptr<Cache>> caches{
+            make_cache(4 * 1024, 64, 4, 32, WritePolicy::WRITE_BACK, AllocationPolicy::READ_ALLOCATE, ReplacementPolicy::LRU)};
+        return make_hierarchy(std::move(caches), std::move(memory), trace, data_mode, insertion);
+    }
 
-            std::cout <<"\n" << line << "\n";
+    std::shared_ptr<MemoryHierarchy> make_model2_hierarchy(std::shared_ptr<MemoryModel> memory, TraceLevel trace,
+                                                           DataMode data_mode, InsertionPolicy insertion) {
+        std::vector<std::shared_ptr<Cache>> caches{
+            make_cache(16 * 1024, 32, 4, 32, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::MRU),
+            make_cache(256, 32, 256 / 32, 32, WritePolicy::WRITE_THROUGH, AllocationPolicy::WRITE_ALLOCATE, ReplacementPolicy::LRU)};
+        return make_hierarchy(std::move(caches), std::move(memory), trace, data_mode, insertion);
+    }
 
-            if (line == "show") {
-                hierarchy->print_caches_state();
-                continue;
+    // Двоичная трасса исполняется без эха строк: обращения читаются прямо из
+    // отображения файла и идут пакетами через query_batch, show и stats - между пакетами
+    static void run_binary_trace(const MappedFile& file, std::shared_ptr<MemoryHierarchy> hierarchy) {
+        constexpr size_t BATCH = 256;
+        std::vector<InQuery> queries(BATCH);
+        std::vector<OutQuery> results(BATCH);
+        size_t pending = 0;
+        auto flush = [&]() {
+            hierarchy->query_batch(queries.data(), pending, results.data());
+            pending = 0;
+        };
+
+        BinaryTraceReader reader(file.data(), file.size());
+        TraceRecord record;
+        while (reader.next(record)) {
+            switch (record.command) {
+                case TraceCommand::LOAD:
+                case TraceCommand::STORE:
+                    queries[pending++] = record.query;
+                    if (pending == BATCH) flush();
+                    break;
+                case TraceCommand::SHOW:
+                    flush();
+                    hierarchy->report().command("show");
+                    hierarchy->print_caches_state();
+                    break;
+                case TraceCommand::STATS:
+                    flush();
+                    hierarchy->report().command("stats");
+                    hierarchy->print_stats(true);
+                    break;
             }
-            size_t size;
-            uint64_t address;
-            Data data;
+        }
+        flush();
+    }
 
-            if (!(iss >> op >> size >> std::hex >> address >> std::dec)) {
-                std::cerr << "Invalid command format\n> ";
-                continue;
+    // Трассы сторонних инструментов идут как двоичные: без эха, пакетами через query_batch
+    static void run_imported_trace(const std::string& path, TraceFormat format,
+                                   std::shared_ptr<MemoryHierarchy> hierarchy) {
+        constexpr size_t BATCH = 256;
+        std::vector<InQuery> queries(BATCH);
+        std::vector<OutQuery> results(BATCH);
+        size_t pending = 0;
+
+        ImportedTraceReader reader(path, format);
+        TraceRecord record;
+        while (reader.next(record)) {
+            queries[pending++] = record.query;
+            if (pending == BATCH) {
+                hierarchy->query_batch(queries.data(), pending, results.data());
+                pending = 0;
             }
+        }
+        hierarchy->query_batch(queries.data(), pending, results.data());
+    }
 
-            if (op == "st") {
-                std::vector<int> values;
-                std::string val_str;
-                while (iss >> val_str) {
-                    try {
-                        uint32_t val = std::stoul(val_str, nullptr, 16);
-                        values.push_back(static_cast<int>(val));
-                    } catch (...) {
-                        std::cerr << "Invalid value format: " << val_str << "\n> ";
-                        continue;
-                    }
-                }
-                
-                size_t size_bytes = size ; 
-                size_t expected_values = size_bytes / sizeof(int);
-                
-                if (values.size() != expected_values) {
-                    std::cerr << "Size mismatch. Expected " << expected_values
-                            << " values, got " << values.size() << " values\n> ";
-                    continue;
-                }
+    namespace {
+        void print_loaded(ReportSink& report, const InQuery& query, const OutQuery& result, size_t elements) {
+            if (query.operation != Operation::READ || !result.hit || !result.returned_data) return;
+            const auto& resp_data = *result.returned_data;
+            report.loaded(resp_data, std::min(elements, resp_data.valid_count));
+        }
+    }
 
-                Data new_data;
-                std::fill(new_data.buffer.begin(), new_data.buffer.end(), 0); 
-                std::copy(values.begin(), values.end(), new_data.buffer.begin()); 
-                
-                data = new_data;
-            }
+    void run_text_record(MemoryHierarchy& hierarchy, TraceCommand command, const InQuery& query, std::string_view line) {
+        hierarchy.report().command(line);
+        switch (command) {
+            case TraceCommand::SHOW:
+                hierarchy.print_caches_state();
+                return;
+            case TraceCommand::STATS:
+                hierarchy.print_stats(true);
+                return;
+            default:
+                break;
+        }
 
-            InQuery query{
-                (op == "ld") ? Operation::READ : Operation::WRITE,
-                address,
-                data,
-                size
-            };
+        OutQuery result = hierarchy.query(query);
+        print_loaded(hierarchy.report(), query, result, (query.size + 31) / 32);
+        hierarchy.print_changes();
+    }
 
-            OutQuery result = hierarchy->query(query);
-            
-            if (op == "ld" && result.hit && result.returned_data) {
-                std::cout << "Data: ";
-                const auto& resp_data = *result.returned_data;
-                size_t elements_to_print = std::min(
-                    (query.size + 31) / 32, 
-                    resp_data.valid_count
-                );
-                for (size_t i = 0; i < elements_to_print; ++i) {
-                    std::cout << resp_data.buffer[i] << " ";
-                }
-                std::cout << std::endl;
+    void run_tests(const std::string& test_file, std::shared_ptr<MemoryHierarchy> hierarchy,
+                   TraceIngestion ingestion, TraceFormat format) {
+        std::unique_ptr<MappedFile> file;
+        try {
+            if (format != TraceFormat::NATIVE) {
+                run_imported_trace(test_file, format, hierarchy);
+                hierarchy->report().flush();
+                return;
             }
-            hierarchy->print_changes();
+            file = std::make_unique<MappedFile>(test_file);
+            if (ingestion == TraceIngestion::PIPELINED) {
+                run_pipelined_trace(*file, test_file, hierarchy);
+                return;
+            }
+            if (is_binary_trace(file->data(), file->size())) {
+                run_binary_trace(*file, hierarchy);
+                hierarchy->report().flush();
+                return;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            exit(1);
         }
-    }
 
-    auto print_result = [](const std::string& op, bool hit, uint64_t address, 
-                          const std::optional<Data>& returned_data) {
-        // std::cout << (hit ? "Hit" : "Miss") << " at 0x" 
-        //           << std::hex << address << std::dec << std::endl;
-        
-        if (op == "ld" && hit && returned_data) {
-            std::cout << "Data: ";
-            for (size_t i = 0; i < returned_data->valid_count; ++i) {
-                std::cout << (*returned_data)[i] << " ";
+        TextTraceReader reader(file->data(), file->size());
+        TraceRecord record;
+        std::string_view line;
+        std::string error;
+        while (reader.next_line(line)) {
+            if (!parse_trace_line(line, record, error)) {
+                if (!error.empty()) {
+                    std::cerr << test_file << ":" << reader.line_number() << ": " << error << std::endl;
+                }
+                continue;
             }
-            std::cout << std::endl;
+            run_text_record(*hierarchy, record.command, record.query, line);
         }
-    };
+        hierarchy->report().flush();
+    }
 
     void process_commands(std::shared_ptr<MemoryHierarchy> hierarchy) {
-        std::string line;
-        std::cout << "Enter commands (ld <size> <addr> | st <size> <addr> <val1> <val2> ...) | show:" << std::endl;
+        std::string line, error;
+        TraceRecord record;
+        size_t line_number = 0;
+        std::cout << "Enter commands (ld <size> <addr> | st <size> <addr> <val1> <val2> ...) | show | stats:" << std::endl;
 
         while (std::getline(std::cin, line)) {
-            std::istringstream iss(line);
-            std::string op;
-
-            if(line == "/n"){continue;}
-            if (line == "show") {
-                hierarchy->print_caches_state();
-                continue;
-            }
-            size_t size;
-            uint64_t address;
-            Data data;
-
-            if (!(iss >> op >> size >> std::hex >> address >> std::dec) and line != "/n") {
-                std::cerr << "Invalid command format\n> ";
+            ++line_number;
+            if (line == "/n") continue;
+            if (!parse_trace_line(line, record, error)) {
+                if (!error.empty()) {
+                    std::cerr << "line " << line_number << ": " << error << "\n> ";
+                }
                 continue;
             }
 
-
-            if (op == "st") {
-                std::vector<int> values;
-                std::string val_str;
-                while (iss >> val_str) {
-                    try {
-                        uint32_t val = std::stoul(val_str, nullptr, 16);
-                        values.push_back(static_cast<int>(val));
-                    } catch (...) {
-                        std::cerr << "Invalid value format: " << val_str << "\n> ";
-                        continue;
-                    }
-                }
-
-                size_t expected_values = size / sizeof(int);
-                
-                if (values.size() != expected_values) {
-                    std::cerr << "Size mismatch. Expected " << expected_values
-                            << " values, got " << values.size() << " values\n> ";
+            switch (record.command) {
+                case TraceCommand::SHOW:
+                    hierarchy->print_caches_state();
                     continue;
-                }
-
-                Data new_data;
-                for (size_t i = 0; i < values.size(); ++i) {
-                    new_data[i] = values[i];
-                }
-                new_data.valid_count = Data::SIZE; 
-                
-                data = new_data;
+                case TraceCommand::STATS:
+                    hierarchy->print_stats(true);
+                    continue;
+                default:
+                    break;
             }
 
-            InQuery query{
-                (op == "ld") ? Operation::READ : Operation::WRITE,
-                address,
-                data,
-                size
-            };
-
-            OutQuery result = hierarchy->query(query);
-            
-            if (op == "ld" && result.hit && result.returned_data) {
-                std::cout << "Data: ";
-                const auto& resp_data = *result.returned_data;
-                for (size_t i = 0; i < resp_data.valid_count; ++i) {
-                    std::cout << resp_data.buffer[i] << " ";
-                }
-                std::cout << std::endl;
-            }
+            OutQuery result = hierarchy->query(record.query);
+            print_loaded(hierarchy->report(), record.query, result, Data::SIZE);
             hierarchy->print_changes();
+            hierarchy->report().flush();
         }
     }
 
@@ -424,7 +603,26 @@ namespace Cache {
             ("init,i", boost::program_options::value<int>()->default_value(0), 
             "Memory init mode (0=zeros, 1=addresses)")
             ("test", boost::program_options::value<std::string>(), 
-            "Run test from file");
+            "Run test from file")
+            ("tags-only", "Track only tags and block state, no data (for hit/miss statistics)")
+            ("pipeline", "Run --test in three threads: trace decoding, simulation and output")
+            ("gen", boost::program_options::value<std::string>(),
+            "Run a synthetic workload instead of --test: pattern[:key=value...], pattern - seq, stride, "
+            "uniform, zipf, chase, mixed; keys - count, footprint, stride, size, reads, alpha, seed, base "
+            "(e.g. zipf:footprint=64M:alpha=0.9)")
+            ("format", boost::program_options::value<std::string>()->default_value("native"),
+            "Trace format for --test (native, din, lackey, champsim); gzip and xz are decompressed on the fly")
+            ("insertion", boost::program_options::value<std::string>()->default_value("normal"),
+            "Insertion policy for all cache levels (normal, bimodal, adaptive)")
+            ("image", boost::program_options::value<std::vector<std::string>>()->composing(),
+            "Memory image file mapped copy-on-write at a 4 KB aligned base address: path@base "
+            "(e.g. heap.bin@0x7f0000000000); may be repeated")
+            ("output-format", boost::program_options::value<std::string>()->default_value("text"),
+            "Output of trace events, memory changes and statistics: text, csv (one event per row), "
+            "json (one JSON object per line) or none (final statistics only)")
+            ("event-trace", boost::program_options::value<std::string>(),
+            "Record binary trace events (cache levels and memory accesses) to a file; "
+            "decode with trace_decode");
         return desc;
     }
 
@@ -458,4 +656,84 @@ namespace Cache {
     {
         return static_cast<MemoryInitMode>(vm["init"].as<int>());
     }
+
+    DataMode get_data_mode(const boost::program_options::variables_map& vm)
+    {
+        return vm.count("tags-only") ? DataMode::TAGS_ONLY : DataMode::FULL;
+    }
+
+    void map_memory_images(MemoryModel& memory, const boost::program_options::variables_map& vm)
+    {
+        if (!vm.count("image")) return;
+        try {
+            for (const auto& text : vm["image"].as<std::vector<std::string>>()) {
+                MemoryImageSpec image = parse_memory_image(text);
+                memory.map_image(image.path, image.base);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            exit(1);
+        }
+    }
+
+    std::shared_ptr<EventLog> get_event_log(const boost::program_options::variables_map& vm)
+    {
+        if (!vm.count("event-trace")) return nullptr;
+        if constexpr (COMPILED_TRACE_LEVEL == TraceLevel::NONE) {
+            std::cerr << "Built with CACHE_TRACE_LEVEL=0, --event-trace is ignored" << std::endl;
+            return nullptr;
+        }
+        try {
+            return std::make_shared<EventLog>(vm["event-trace"].as<std::string>());
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            exit(1);
+        }
+    }
+
+    TraceIngestion get_trace_ingestion(const boost::program_options::variables_map& vm)
+    {
+        return vm.count("pipeline") ? TraceIngestion::PIPELINED : TraceIngestion::SERIAL;
+    }
+
+    TraceFormat get_trace_format(const boost::program_options::variables_map& vm)
+    {
+        try {
+            return parse_trace_format(vm["format"].as<std::string>());
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            exit(1);
+        }
+    }
+
+    OutputFormat get_output_format(const boost::program_options::variables_map& vm)
+    {
+        try {
+            return parse_output_format(vm["output-format"].as<std::string>());
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            exit(1);
+        }
+    }
+
+    WorkloadSpec get_workload_spec(const boost::program_options::variables_map& vm)
+    {
+        try {
+            return parse_workload_spec(vm["gen"].as<std::string>());
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            exit(1);
+        }
+    }
+
+    InsertionPolicy get_insertion_policy(const boost::program_options::variables_map& vm)
+    {
+        const auto& name = vm["insertion"].as<std::string>();
+        if (name == "bimodal") return InsertionPolicy::BIMODAL;
+        if (name == "adaptive") return InsertionPolicy::ADAPTIVE;
+        if (name != "normal") {
+            std::cerr << "Unknown insertion policy: " << name << ", using normal" << std::endl;
+        }
+        return InsertionPolicy::NORMAL;
+    }
 }
\ No newline at end of file
@@ -13,28 +13,31 @@ int main(int argc, char* argv[]) {
 
     TraceLevel trace = get_trace_level(vm);
     MemoryInitMode init = get_memory_init_mode(vm);
-
-    auto cache = std::make_shared<Cache::Cache>(
-        4 * 1024, 64, 4, 32,
-        WritePolicy::WRITE_BACK,
-        AllocationPolicy::READ_ALLOCATE,
-        ReplacementPolicy::LRU
-    );
+    DataMode data_mode = get_data_mode(vm);
+    InsertionPolicy insertion = get_insertion_policy(vm);
+    OutputFormat output = get_output_format(vm);
 
     auto memory = std::make_shared<MemoryModel>(trace);
     memory->initialize(init);
-    
-    std::vector<std::shared_ptr<Cache::Cache>> caches;
-    caches.push_back(cache);
-    auto hierarchy = std::make_shared<MemoryHierarchy>(caches, memory, trace);
+    memory->set_report(std::make_shared<ReportSink>(std::cout, output));
+    memory->set_event_log(get_event_log(vm));
+    map_memory_images(*memory, vm);
+    auto hierarchy = make_model1_hierarchy(memory, trace, data_mode, insertion);
 
-    std::cout << "L1: 4KB, 64B blocks, 4-way, Read-Allocate, Write-Back, LRU\n";
+    // Заголовок не должен попадать в поток событий CSV/JSON
+    if (!memory->report().structured()) {
+        std::cout << "L1: 4KB, 64B blocks, 4-way, Read-Allocate, Write-Back, LRU\n";
+    }
     
-    if (vm.count("test")) {
-        run_tests(vm["test"].as<std::string>(), hierarchy);
+    if (vm.count("gen")) {
+        run_workload(get_workload_spec(vm), *hierarchy);
+    } else if (vm.count("test")) {
+        run_tests(vm["test"].as<std::string>(), hierarchy, get_trace_ingestion(vm), get_trace_format(vm));
     } else {
         process_commands(hierarchy);
     }
+
+    hierarchy->print_stats();
     
     return 0;
 }
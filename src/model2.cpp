@@ -12,37 +12,32 @@ int main(int argc, char* argv[]) {
 
     TraceLevel trace = get_trace_level(vm);
     MemoryInitMode init = get_memory_init_mode(vm);
+    DataMode data_mode = get_data_mode(vm);
+    InsertionPolicy insertion = get_insertion_policy(vm);
+    OutputFormat output = get_output_format(vm);
 
-    auto l1_cache = std::make_shared<Cache::Cache>(
-        16 * 1024, 32, 4, 32,
-        WritePolicy::WRITE_BACK,
-        AllocationPolicy::BOTH,
-        ReplacementPolicy::MRU
-    );
-
-    auto l2_cache = std::make_shared<Cache::Cache>(
-        256, 32, 256/32, 32,
-        WritePolicy::WRITE_THROUGH,
-        AllocationPolicy::WRITE_ALLOCATE,
-        ReplacementPolicy::LRU
-    );
-    
     auto memory = std::make_shared<MemoryModel>(trace);
     memory->initialize(init);
-    
-    std::vector<std::shared_ptr<Cache::Cache>> caches;
-    caches.push_back(l1_cache);
-    caches.push_back(l2_cache);
-    auto hierarchy = std::make_shared<MemoryHierarchy>(caches, memory, trace);
+    memory->set_report(std::make_shared<ReportSink>(std::cout, output));
+    memory->set_event_log(get_event_log(vm));
+    map_memory_images(*memory, vm);
+    auto hierarchy = make_model2_hierarchy(memory, trace, data_mode, insertion);
 
-    std::cout << "L1: 16KB, 32B blocks, 4-way, BOTH-Allocate, Write-Back, MRU\n"      
-    << "L2: 256B, 32B blocks, Fully-Assoc, Write-Allocate, Write-Through, LRU\n";
+    // Заголовок не должен попадать в поток событий CSV/JSON
+    if (!memory->report().structured()) {
+        std::cout << "L1: 16KB, 32B blocks, 4-way, BOTH-Allocate, Write-Back, MRU\n"
+        << "L2: 256B, 32B blocks, Fully-Assoc, Write-Allocate, Write-Through, LRU\n";
+    }
     
-    if (vm.count("test")) {
-        run_tests(vm["test"].as<std::string>(), hierarchy);
+    if (vm.count("gen")) {
+        run_workload(get_workload_spec(vm), *hierarchy);
+    } else if (vm.count("test")) {
+        run_tests(vm["test"].as<std::string>(), hierarchy, get_trace_ingestion(vm), get_trace_format(vm));
     } else {
         process_commands(hierarchy);
     }
+
+    hierarchy->print_stats();
     
     return 0;
 }
\ No newline at end of file
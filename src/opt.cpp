@@ -0,0 +1,144 @@
+#include "../include/opt.hpp"
+
+#include <iomanip>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace Cache {
+    void NextUseTable::read_at(uint64_t first, size_t count) {
+        if (fseeko(_file.get(), static_cast<off_t>(first * sizeof(uint64_t)), SEEK_SET) != 0 ||
+            std::fread(_chunk.data(), sizeof(uint64_t), count, _file.get()) != count) {
+            throw std::runtime_error("Cannot read next-use table");
+        }
+    }
+
+    void NextUseTable::write_at(uint64_t first, size_t count) {
+        if (fseeko(_file.get(), static_cast<off_t>(first * sizeof(uint64_t)), SEEK_SET) != 0 ||
+            std::fwrite(_chunk.data(), sizeof(uint64_t), count, _file.get()) != count) {
+            throw std::runtime_error("Cannot write next-use table");
+        }
+    }
+
+    NextUseTable::NextUseTable(AccessReader& reader, uint64_t block_size, size_t chunk)
+        : _file(std::tmpfile()), _chunk(std::max<size_t>(chunk, 1)) {
+        if (!_file) {
+            throw std::runtime_error("Cannot create temporary file for next-use table");
+        }
+        unsigned offset_bits = static_cast<unsigned>(__builtin_ctzll(block_size));
+
+        // Проход вперёд: номера блоков
+        SweepAccess access;
+        size_t filled = 0;
+        while (reader.next(access)) {
+            _chunk[filled++] = access.address >> offset_bits;
+            if (filled == _chunk.size()) {
+                write_at(_size, filled);
+                _size += filled;
+                filled = 0;
+            }
+        }
+        if (filled) write_at(_size, filled);
+        _size += filled;
+
+        // Проход назад по кускам: номер блока заменяется номером следующего обращения к нему
+        std::unordered_map<uint64_t, uint64_t> next_seen;
+        for (uint64_t end = _size; end > 0;) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(_chunk.size(), end));
+            uint64_t first = end - count;
+            read_at(first, count);
+            for (size_t i = count; i-- > 0;) {
+                auto [it, inserted] = next_seen.try_emplace(_chunk[i], first + i);
+                _chunk[i] = inserted ? OptPolicy::NEVER : it->second;
+                it->second = first + i;
+            }
+            write_at(first, count);
+            end = first;
+        }
+        rewind();
+    }
+
+    void NextUseTable::rewind() {
+        _read = 0;
+        _chunk_pos = 0;
+        _chunk_fill = 0;
+    }
+
+    uint64_t NextUseTable::next() {
+        if (_chunk_pos == _chunk_fill) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(_chunk.size(), _size - _read));
+            if (count == 0) {
+                throw std::runtime_error("Next-use table is shorter than the trace");
+            }
+            read_at(_read, count);
+            _read += count;
+            _chunk_fill = count;
+            _chunk_pos = 0;
+        }
+        return _chunk[_chunk_pos++];
+    }
+
+    std::vector<PolicyResult> compare_with_opt(const OptConfig& config, const AccessReaderFactory& open) {
+        std::unique_ptr<AccessReader> reader = open();
+        NextUseTable table(*reader, config.block_size, config.chunk);
+
+        std::vector<ReplacementPolicy> policies{ReplacementPolicy::OPT, ReplacementPolicy::LRU, ReplacementPolicy::MRU,
+                                                ReplacementPolicy::RANDOM, ReplacementPolicy::PLRU, ReplacementPolicy::NRU,
+                                                ReplacementPolicy::SRRIP, ReplacementPolicy::BRRIP};
+        std::vector<std::unique_ptr<Cache>> caches;
+        std::vector<PolicyResult> results;
+        for (ReplacementPolicy policy : policies) {
+            if (policy == ReplacementPolicy::PLRU && (config.associativity & (config.associativity - 1)) != 0) continue;
+            caches.push_back(std::make_unique<Cache>(config.size, config.block_size, config.associativity,
+                                                     config.address_bits, config.write_policy, config.alloc_policy,
+                                                     policy));
+            caches.back()->set_data_mode(DataMode::TAGS_ONLY);
+            results.push_back({policy, {}});
+        }
+
+        reader = open();
+        SweepAccess access;
+        InQuery query;
+        uint64_t count = 0;
+        while (reader->next(access)) {
+            if (count++ == table.size()) {
+                throw std::runtime_error("Trace changed between passes");
+            }
+            caches.front()->set_next_use(table.next());
+            query.operation = access.operation;
+            query.address = access.address;
+            query.size = access.size;
+            query.data.valid_count = access.operation == Operation::WRITE
+                ? std::min<size_t>((access.size + sizeof(int) - 1) / sizeof(int), Data::SIZE) : 0;
+            for (auto& cache : caches) cache->query(query);
+        }
+        if (count != table.size()) {
+            throw std::runtime_error("Trace changed between passes");
+        }
+
+        for (size_t i = 0; i < caches.size(); ++i) results[i].stats = caches[i]->get_stats();
+        return results;
+    }
+
+    void write_opt_gap_csv(std::ostream& out, const std::vector<PolicyResult>& results, bool per_set) {
+        out << "policy,set,accesses,misses,miss_ratio,opt_misses,gap\n";
+        if (results.empty()) return;
+        const CacheStats& opt = results.front().stats;
+        auto row = [&](const char* policy, const std::string& set, uint64_t accesses, uint64_t misses,
+                       uint64_t opt_misses) {
+            out << policy << "," << set << "," << accesses << "," << misses << ","
+                << std::fixed << std::setprecision(6)
+                << (accesses ? static_cast<double>(misses) / accesses : 0.0) << std::defaultfloat << ","
+                << opt_misses << "," << static_cast<int64_t>(misses - opt_misses) << "\n";
+        };
+        for (const auto& result : results) {
+            const char* name = replacement_policy_name(result.policy);
+            const CacheStats& stats = result.stats;
+            row(name, "all", stats.accesses(), stats.misses(), opt.misses());
+            if (!per_set) continue;
+            for (size_t set = 0; set < stats.set_accesses.size(); ++set) {
+                if (stats.set_accesses[set] == 0) continue;
+                row(name, std::to_string(set), stats.set_accesses[set], stats.set_misses[set], opt.set_misses[set]);
+            }
+        }
+    }
+}
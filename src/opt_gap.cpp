@@ -0,0 +1,91 @@
+#include "memory.hpp"
+#include "opt.hpp"
+
+#include <chrono>
+#include <fstream>
+
+using namespace Cache;
+namespace po = boost::program_options;
+
+// Запас над существующими политиками вытеснения: OPT (Belady) и все политики на
+// одной геометрии, разница в промахах по всему кэшу и по наборам
+int main(int argc, char* argv[]) {
+    po::options_description desc("OPT Gap Options");
+    desc.add_options()
+        ("help,h", "Show help message")
+        ("test", po::value<std::string>(), "Trace file")
+        ("format", po::value<std::string>()->default_value("native"), "Trace format (native, din, lackey, champsim)")
+        ("gen", po::value<std::string>(), "Synthetic workload instead of a trace, as in model1 --gen")
+        ("size", po::value<std::string>()->default_value("32K"), "Cache size")
+        ("block", po::value<std::string>()->default_value("64"), "Block size")
+        ("ways", po::value<size_t>()->default_value(8), "Associativity")
+        ("write", po::value<std::string>()->default_value("wb"), "Write policy (wb, wt)")
+        ("alloc", po::value<std::string>()->default_value("read"), "Allocation policy (read, write, both)")
+        ("address-bits", po::value<uint64_t>()->default_value(48), "Address width")
+        ("chunk", po::value<std::string>()->default_value("1M"), "Accesses per chunk of the next-use table")
+        ("per-set", "Also report every set")
+        ("output,o", po::value<std::string>(), "CSV file (default stdout)");
+
+    po::variables_map vm;
+    try {
+        vm = parse_command_line_args(argc, argv, desc);
+    } catch (const po::error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (handle_help_option(vm, desc)) {
+        return 0;
+    }
+    if (vm.count("test") == vm.count("gen")) {
+        std::cerr << "Error: exactly one of --test and --gen is required" << std::endl;
+        return 1;
+    }
+
+    std::vector<PolicyResult> results;
+    try {
+        OptConfig config{parse_amount("size", vm["size"].as<std::string>()),
+                         parse_amount("block", vm["block"].as<std::string>()),
+                         vm["ways"].as<size_t>(),
+                         parse_write_policy(vm["write"].as<std::string>()),
+                         parse_alloc_policy(vm["alloc"].as<std::string>()),
+                         vm["address-bits"].as<uint64_t>(),
+                         static_cast<size_t>(parse_amount("chunk", vm["chunk"].as<std::string>()))};
+        SweepConfig geometry{config.size, config.block_size, config.associativity, config.write_policy,
+                             config.alloc_policy, ReplacementPolicy::LRU, 1, 0, 0};
+        if (!is_valid_config(geometry)) {
+            throw std::invalid_argument("Unsupported cache geometry");
+        }
+
+        AccessReaderFactory open;
+        if (vm.count("gen")) {
+            WorkloadSpec spec = parse_workload_spec(vm["gen"].as<std::string>());
+            open = [spec] { return std::make_unique<AccessReader>(spec); };
+        } else {
+            std::string path = vm["test"].as<std::string>();
+            TraceFormat format = get_trace_format(vm);
+            open = [path, format] { return std::make_unique<AccessReader>(path, format); };
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        results = compare_with_opt(config, open);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << results.front().stats.accesses() << " accesses, " << results.size() << " policies in "
+                  << elapsed.count() << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    bool per_set = vm.count("per-set");
+    if (vm.count("output")) {
+        std::ofstream out(vm["output"].as<std::string>());
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open output file: " << vm["output"].as<std::string>() << std::endl;
+            return 1;
+        }
+        write_opt_gap_csv(out, results, per_set);
+    } else {
+        write_opt_gap_csv(std::cout, results, per_set);
+    }
+    return 0;
+}
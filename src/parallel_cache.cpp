@@ -0,0 +1,206 @@
+#include "../include/parallel_cache.hpp"
+#include "../include/static_cache.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace Cache {
+    namespace {
+        size_t log2_floor(uint64_t value) {
+            size_t bits = 0;
+            while (value >>= 1) ++bits;
+            return bits;
+        }
+
+        size_t log2_ceil(uint64_t value) {
+            size_t bits = log2_floor(value);
+            return (uint64_t{1} << bits) < value ? bits + 1 : bits;
+        }
+    }
+
+    bool SetPartitionedCache::sets_independent(ReplacementPolicy rp, InsertionPolicy insertion) {
+        if (insertion != InsertionPolicy::NORMAL) return false;
+        return rp != ReplacementPolicy::RANDOM && rp != ReplacementPolicy::BRRIP;
+    }
+
+    SetPartitionedCache::SetPartitionedCache(size_t size, uint64_t block_size, size_t associativity, uint64_t address_bits,
+                                             WritePolicy wp, AllocationPolicy ap, ReplacementPolicy rp,
+                                             InsertionPolicy insertion, size_t threads)
+        : _threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          _shard_bits(0),
+          _offset_bits(log2_floor(block_size)),
+          _index_bits(log2_floor(size / (block_size * associativity))) {
+        if (sets_independent(rp, insertion)) {
+            // Шардов не меньше, чем потоков, но не больше, чем наборов
+            _shard_bits = std::min(log2_ceil(_threads), _index_bits);
+        }
+        for (size_t shard = 0; shard < (size_t{1} << _shard_bits); ++shard) {
+            auto cache = make_cache(size >> _shard_bits, block_size, associativity, address_bits - _shard_bits, wp, ap, rp);
+            cache->set_insertion_policy(insertion);
+            auto memory = std::make_shared<MemoryModel>();
+            auto hierarchy = std::make_unique<MemoryHierarchy>(std::vector<std::shared_ptr<Cache>>{cache}, memory);
+            _shards.push_back({std::move(cache), std::move(memory), std::move(hierarchy)});
+        }
+        _shard_begin.resize(_shards.size() + 1);
+
+        size_t threads_used = std::min(_threads, _shards.size());
+        for (size_t t = 1; t < threads_used; ++t) {
+            _workers.emplace_back(&SetPartitionedCache::work, this, t);
+        }
+    }
+
+    SetPartitionedCache::~SetPartitionedCache() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _batch_ready.notify_all();
+        for (auto& worker : _workers) worker.join();
+    }
+
+    // Младшие _shard_bits бит номера набора выбирают шард и из адреса убираются
+    uint64_t SetPartitionedCache::to_shard(uint64_t address) const {
+        uint64_t offset_mask = (uint64_t{1} << _offset_bits) - 1;
+        return ((address >> (_offset_bits + _shard_bits)) << _offset_bits) | (address & offset_mask);
+    }
+
+    uint64_t SetPartitionedCache::from_shard(uint64_t address, size_t shard) const {
+        uint64_t offset_mask = (uint64_t{1} << _offset_bits) - 1;
+        return ((address >> _offset_bits) << (_offset_bits + _shard_bits)) |
+               (static_cast<uint64_t>(shard) << _offset_bits) | (address & offset_mask);
+    }
+
+    // Подсчёт по шардам и раскладка номеров: внутри шарда порядок программы сохраняется
+    void SetPartitionedCache::partition(const InQuery* queries, size_t count) {
+        if (count > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("SetPartitionedCache: batch is too large");
+        }
+        _shard_ids.resize(count);
+        _order.resize(count);
+        std::fill(_shard_begin.begin(), _shard_begin.end(), 0);
+        for (size_t i = 0; i < count; ++i) {
+            auto shard = static_cast<uint32_t>(shard_of(queries[i].address));
+            _shard_ids[i] = shard;
+            ++_shard_begin[shard + 1];
+        }
+        for (size_t shard = 1; shard < _shard_begin.size(); ++shard) {
+            _shard_begin[shard] += _shard_begin[shard - 1];
+        }
+        std::vector<size_t> next(_shard_begin.begin(), _shard_begin.end() - 1);
+        for (size_t i = 0; i < count; ++i) {
+            _order[next[_shard_ids[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Поток first_shard берёт шарды first_shard, first_shard + потоков, ...;
+    // results[i] пишет ровно один поток
+    void SetPartitionedCache::run_shards(size_t first_shard) {
+        size_t shard_step = _workers.size() + 1;
+        InQuery local;
+        for (size_t shard = first_shard; shard < _shards.size(); shard += shard_step) {
+            Cache& cache = *_shards[shard].cache;
+            MemoryHierarchy& hierarchy = *_shards[shard].hierarchy;
+            const bool prefetch = cache.prefetch_useful();
+            size_t end = _shard_begin[shard + 1];
+            for (size_t k = _shard_begin[shard]; k < end; ++k) {
+                if (prefetch && k + BATCH_PREFETCH_DISTANCE < end) {
+                    cache.prefetch(to_shard(_queries[_order[k + BATCH_PREFETCH_DISTANCE]].address));
+                }
+                size_t i = _order[k];
+                local = _queries[i];
+                local.address = to_shard(local.address);
+                // Пакет из одного обращения: ответ пишется сразу в results[i], без копии OutQuery
+                OutQuery& result = _results[i];
+                hierarchy.query_batch(&local, 1, &result);
+                for (auto& request : result.out) {
+                    request.address = from_shard(request.address, shard);
+                }
+            }
+        }
+    }
+
+    void SetPartitionedCache::work(size_t first_shard) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _batch_ready.wait(lock, [&] { return _stopping || _generation != seen; });
+                if (_stopping) return;
+                seen = _generation;
+            }
+            run_shards(first_shard);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (--_running > 0) continue;
+            }
+            _batch_done.notify_one();
+        }
+    }
+
+    void SetPartitionedCache::query_batch(const InQuery* queries, size_t count, OutQuery* results) {
+        if (_shards.size() == 1) {
+            _shards.front().hierarchy->query_batch(queries, count, results);
+            return;
+        }
+
+        partition(queries, count);
+        _queries = queries;
+        _results = results;
+        if (_workers.empty()) {
+            run_shards(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_generation;
+            _running = _workers.size();
+        }
+        _batch_ready.notify_all();
+        run_shards(0);
+        std::unique_lock<std::mutex> lock(_mutex);
+        _batch_done.wait(lock, [&] { return _running == 0; });
+    }
+
+    void SetPartitionedCache::set_data_mode(DataMode mode) {
+        for (auto& shard : _shards) {
+            shard.cache->set_data_mode(mode);
+            shard.memory->set_data_mode(mode);
+        }
+    }
+
+    void SetPartitionedCache::seed_replacement(uint64_t seed) {
+        for (auto& shard : _shards) shard.cache->seed_replacement(seed);
+    }
+
+    CacheStats SetPartitionedCache::get_stats() const {
+        CacheStats merged(size_t{1} << _index_bits);
+        for (size_t shard = 0; shard < _shards.size(); ++shard) {
+            const CacheStats& stats = _shards[shard].cache->get_stats();
+            merged.reads += stats.reads;
+            merged.writes += stats.writes;
+            merged.read_hits += stats.read_hits;
+            merged.write_hits += stats.write_hits;
+            merged.fills += stats.fills;
+            merged.evictions += stats.evictions;
+            merged.dirty_writebacks += stats.dirty_writebacks;
+            merged.write_throughs += stats.write_throughs;
+            merged.bypasses += stats.bypasses;
+            for (size_t local = 0; local < stats.set_accesses.size(); ++local) {
+                size_t index = (local << _shard_bits) | shard;
+                merged.set_accesses[index] = stats.set_accesses[local];
+                merged.set_misses[index] = stats.set_misses[local];
+            }
+        }
+        return merged;
+    }
+
+    MemoryStats SetPartitionedCache::get_memory_stats() const {
+        MemoryStats merged;
+        for (const auto& shard : _shards) {
+            merged.reads += shard.memory->get_stats().reads;
+            merged.writes += shard.memory->get_stats().writes;
+        }
+        return merged;
+    }
+}
@@ -0,0 +1,250 @@
+#include "../include/pipeline.hpp"
+#include "../include/spsc_ring.hpp"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace Cache {
+    namespace {
+        constexpr size_t BATCH_SIZE = 256;
+        constexpr size_t BATCH_SLOTS = 8;
+        constexpr size_t CHUNK_BYTES = 64 * 1024;
+        constexpr size_t CHUNK_SLOTS = 8;
+
+        struct TraceError {
+            size_t before;      // индекс записи пакета, перед которой стояла строка
+            size_t line_number;
+            std::string message;
+        };
+
+        struct TraceBatch {
+            std::array<InQuery, BATCH_SIZE> queries;
+            std::array<TraceCommand, BATCH_SIZE> commands;
+            std::array<std::string_view, BATCH_SIZE> lines; // эхо: строка файла или имя команды
+            size_t count = 0;
+            std::vector<TraceError> errors; // ёмкость сохраняется между проходами по кольцу
+            bool last = false;
+            std::exception_ptr failure;
+        };
+
+        struct OutputChunk {
+            std::array<char, CHUNK_BYTES> bytes;
+            size_t size = 0;
+            bool last = false;
+        };
+
+        using BatchRing = SpscRing<TraceBatch, BATCH_SLOTS>;
+        using ChunkRing = SpscRing<OutputChunk, CHUNK_SLOTS>;
+
+        TraceBatch& start_batch(BatchRing& ring) {
+            TraceBatch& batch = ring.acquire();
+            batch.count = 0;
+            batch.errors.clear();
+            batch.last = false;
+            batch.failure = nullptr;
+            return batch;
+        }
+
+        void decode(const MappedFile& file, bool binary, BatchRing& ring) {
+            TraceBatch* batch = &start_batch(ring);
+            auto add = [&](const TraceRecord& record, std::string_view line) {
+                size_t i = batch->count++;
+                batch->commands[i] = record.command;
+                batch->queries[i] = record.query;
+                batch->lines[i] = line;
+                if (batch->count == BATCH_SIZE) {
+                    ring.commit();
+                    batch = &start_batch(ring);
+                }
+            };
+
+            try {
+                TraceRecord record;
+                if (binary) {
+                    BinaryTraceReader reader(file.data(), file.size());
+                    while (reader.next(record)) {
+                        add(record, record.command == TraceCommand::SHOW ? "show" : "stats");
+                    }
+                } else {
+                    TextTraceReader reader(file.data(), file.size());
+                    std::string_view line;
+                    std::string error;
+                    while (reader.next_line(line)) {
+                        if (parse_trace_line(line, record, error)) {
+                            add(record, line);
+                        } else if (!error.empty()) {
+                            batch->errors.push_back({batch->count, reader.line_number(), error});
+                        }
+                    }
+                }
+            } catch (...) {
+                batch->failure = std::current_exception();
+            }
+            batch->last = true;
+            ring.commit();
+        }
+
+        // Буфер std::cout на время прогона: заполняет блоки прямо в слотах кольца
+        class ChunkedOutput : public std::streambuf {
+        private:
+            ChunkRing& _ring;
+            OutputChunk* _chunk = nullptr;
+
+            void next_chunk() {
+                _chunk = &_ring.acquire();
+                setp(_chunk->bytes.data(), _chunk->bytes.data() + _chunk->bytes.size());
+            }
+
+            void publish(bool last) {
+                _chunk->size = static_cast<size_t>(pptr() - pbase());
+                _chunk->last = last;
+                _ring.commit();
+                if (!last) next_chunk();
+            }
+
+        protected:
+            int_type overflow(int_type c) override {
+                publish(false);
+                if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                    *pptr() = traits_type::to_char_type(c);
+                    pbump(1);
+                }
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char* s, std::streamsize n) override {
+                std::streamsize written = 0;
+                while (written < n) {
+                    if (pptr() == epptr()) publish(false);
+                    std::streamsize part = std::min<std::streamsize>(n - written, epptr() - pptr());
+                    traits_type::copy(pptr(), s + written, static_cast<size_t>(part));
+                    pbump(static_cast<int>(part));
+                    written += part;
+                }
+                return written;
+            }
+
+        public:
+            explicit ChunkedOutput(ChunkRing& ring) : _ring(ring) { next_chunk(); }
+
+            // Отдаёт последний неполный блок и сообщает потоку вывода о конце
+            void finish() { publish(true); }
+        };
+
+        void write_output(ChunkRing& ring, std::streambuf* sink) {
+            for (bool last = false; !last;) {
+                OutputChunk& chunk = ring.front();
+                sink->sputn(chunk.bytes.data(), static_cast<std::streamsize>(chunk.size));
+                last = chunk.last;
+                ring.release();
+            }
+            sink->pubsync();
+        }
+
+        // Потоки разбора и вывода на время прогона. Деструктор завершает прогон на любом
+        // пути, в том числе при исключении в simulate: возвращает буфер std::cout, отдаёт
+        // потоку вывода последний блок, дочитывает кольцо пакетов, чтобы разбор не ждал
+        // свободного слота, и ждёт оба потока
+        class PipelineRun {
+        private:
+            BatchRing& _batches;
+            std::streambuf* _sink;
+            ChunkedOutput _output;
+            std::thread _writer;
+            std::thread _decoder;
+            bool _batches_done = false;
+
+        public:
+            PipelineRun(const MappedFile& file, bool binary, BatchRing& batches, ChunkRing& chunks)
+                : _batches(batches), _sink(std::cout.rdbuf()), _output(chunks) {
+                _writer = std::thread(write_output, std::ref(chunks), _sink);
+                try {
+                    _decoder = std::thread(decode, std::cref(file), binary, std::ref(batches));
+                } catch (...) {
+                    _output.finish();
+                    _writer.join();
+                    throw;
+                }
+                std::cout.rdbuf(&_output);
+            }
+
+            ~PipelineRun() {
+                std::cout.rdbuf(_sink);
+                _output.finish();
+                while (!_batches_done) {
+                    _batches_done = _batches.front().last;
+                    _batches.release();
+                }
+                _decoder.join();
+                _writer.join();
+            }
+
+            PipelineRun(const PipelineRun&) = delete;
+            PipelineRun& operator=(const PipelineRun&) = delete;
+
+            // simulate дошёл до последнего пакета
+            void batches_done() { _batches_done = true; }
+        };
+
+        // Исполняет пакеты по порядку; в двоичной трассе обращения между show/stats
+        // идут через query_batch, как в последовательном прогоне
+        std::exception_ptr simulate(BatchRing& ring, bool binary, const std::string& name,
+                                    MemoryHierarchy& hierarchy) {
+            std::vector<OutQuery> results(BATCH_SIZE);
+            for (;;) {
+                TraceBatch& batch = ring.front();
+                size_t next_error = 0;
+                size_t run_start = 0;
+                auto report_errors = [&](size_t before) {
+                    for (; next_error < batch.errors.size() && batch.errors[next_error].before == before; ++next_error) {
+                        const TraceError& error = batch.errors[next_error];
+                        std::cerr << name << ":" << error.line_number << ": " << error.message << std::endl;
+                    }
+                };
+                auto run_queries = [&](size_t end) {
+                    if (end > run_start) {
+                        hierarchy.query_batch(&batch.queries[run_start], end - run_start, results.data());
+                    }
+                    run_start = end + 1;
+                };
+
+                for (size_t i = 0; i < batch.count; ++i) {
+                    report_errors(i);
+                    TraceCommand command = batch.commands[i];
+                    if (binary) {
+                        if (command == TraceCommand::LOAD || command == TraceCommand::STORE) continue;
+                        run_queries(i);
+                    }
+                    run_text_record(hierarchy, command, batch.queries[i], batch.lines[i]);
+                }
+                report_errors(batch.count);
+                if (binary) run_queries(batch.count);
+
+                bool last = batch.last;
+                std::exception_ptr failure = batch.failure;
+                ring.release();
+                if (last) return failure;
+            }
+        }
+    }
+
+    void run_pipelined_trace(const MappedFile& file, const std::string& name,
+                             std::shared_ptr<MemoryHierarchy> hierarchy) {
+        bool binary = is_binary_trace(file.data(), file.size());
+        auto batches = std::make_unique<BatchRing>();
+        auto chunks = std::make_unique<ChunkRing>();
+
+        std::exception_ptr failure;
+        {
+            PipelineRun run(file, binary, *batches, *chunks);
+            failure = simulate(*batches, binary, name, *hierarchy);
+            run.batches_done();
+            hierarchy->report().flush(); // хвост буфера событий должен уйти в кольцо до возврата буфера std::cout
+        }
+        if (failure) std::rethrow_exception(failure);
+    }
+}
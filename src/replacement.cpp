@@ -0,0 +1,198 @@
+#include "../include/replacement.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace Cache {
+
+    size_t LruPolicy::victim(size_t index) {
+        const uint64_t* stamps = _stamps.data() + index * _ways;
+        size_t oldest = 0;
+        for (size_t way = 1; way < _ways; ++way) {
+            if (stamps[way] < stamps[oldest]) oldest = way;
+        }
+        return oldest;
+    }
+
+    size_t OptPolicy::victim(size_t index) {
+        const uint64_t* next_use = _next_use.data() + index * _ways;
+        size_t furthest = 0;
+        for (size_t way = 1; way < _ways; ++way) {
+            if (next_use[way] > next_use[furthest]) furthest = way;
+        }
+        return furthest;
+    }
+
+    TreePlruPolicy::TreePlruPolicy(size_t sets, size_t ways)
+        : _ways(ways), _levels(0), _tree(sets, ways) {
+        if (ways == 0 || (ways & (ways - 1)) != 0) {
+            throw std::invalid_argument("PLRU requires power-of-two associativity");
+        }
+        while ((size_t{1} << _levels) < ways) ++_levels;
+    }
+
+    void TreePlruPolicy::touch(size_t index, size_t way) {
+        size_t node = 1;
+        for (size_t level = _levels; level-- > 0;) {
+            size_t right = (way >> level) & 1;
+            _tree.assign(index, node, !right); // направляем вытеснение в другое поддерево
+            node = node * 2 + right;
+        }
+    }
+
+    size_t TreePlruPolicy::victim(size_t index) {
+        size_t node = 1;
+        for (size_t level = 0; level < _levels; ++level) {
+            node = node * 2 + (_tree.test(index, node) ? 1 : 0);
+        }
+        return node - _ways;
+    }
+
+    void NruPolicy::touch(size_t index, size_t way) {
+        _referenced.assign(index, way, true);
+
+        uint64_t* bits = _referenced.set(index);
+        for (size_t word = 0; word < _referenced.words(); ++word) {
+            if (bits[word] != _referenced.word_mask(word)) return;
+        }
+        // Все пути отмечены: начинаем новую эпоху, оставляя только текущий
+        for (size_t word = 0; word < _referenced.words(); ++word) bits[word] = 0;
+        _referenced.assign(index, way, true);
+    }
+
+    size_t NruPolicy::victim(size_t index) {
+        const uint64_t* bits = _referenced.set(index);
+        for (size_t word = 0; word < _referenced.words(); ++word) {
+            uint64_t free = ~bits[word] & _referenced.word_mask(word);
+            if (free) return word * 64 + static_cast<size_t>(__builtin_ctzll(free));
+        }
+        return 0;
+    }
+
+    size_t RripPolicy::victim(size_t index) {
+        uint64_t* high = _high.set(index);
+        uint64_t* low = _low.set(index);
+        const size_t words = _high.words();
+
+        // Не более трёх шагов старения: после них хотя бы один путь достигает RRPV = 3
+        for (;;) {
+            for (size_t word = 0; word < words; ++word) {
+                uint64_t distant = high[word] & low[word] & _high.word_mask(word);
+                if (distant) return word * 64 + static_cast<size_t>(__builtin_ctzll(distant));
+            }
+            // RRPV += 1 для всех путей: 00 -> 01 -> 10 -> 11
+            for (size_t word = 0; word < words; ++word) {
+                uint64_t mask = _high.word_mask(word);
+                high[word] = (high[word] | low[word]) & mask;
+                low[word] = ~low[word] & mask;
+            }
+        }
+    }
+
+    InsertionController::InsertionController(InsertionPolicy policy, size_t sets)
+        : _policy(policy), _roles(sets, SetRole::FOLLOWER), _last_choice(sets, LastChoice::NONE) {
+        if (!supports(policy, sets)) {
+            throw std::invalid_argument("Adaptive insertion needs at least " + std::to_string(MIN_ADAPTIVE_SETS) +
+                                        " sets, cache has " + std::to_string(sets));
+        }
+        if (policy != InsertionPolicy::ADAPTIVE) return;
+
+        // Complement select: наборы делятся на 2^k групп по старшим битам индекса, в каждой группе
+        // лидер NORMAL - набор, у которого младшие k бит равны номеру группы, лидер BIMODAL - инверсии номера.
+        // При k >= 2 лидеров каждой политики - не больше четверти наборов
+        size_t bits = 0;
+        while ((size_t{1} << bits) < sets) ++bits;
+        size_t k = std::min<size_t>(5, bits / 2);
+        size_t mask = (size_t{1} << k) - 1;
+        for (size_t index = 0; index < sets; ++index) {
+            size_t group = index >> (bits - k);
+            size_t low = index & mask;
+            if (low == group) {
+                _roles[index] = SetRole::LEADER_NORMAL;
+            } else if (low == (~group & mask)) {
+                _roles[index] = SetRole::LEADER_BIMODAL;
+            }
+        }
+    }
+
+    bool InsertionController::insert_distant(size_t index) {
+        switch (_policy) {
+            case InsertionPolicy::NORMAL:
+                return false;
+            case InsertionPolicy::BIMODAL:
+                return bimodal_draw();
+            case InsertionPolicy::ADAPTIVE:
+                break;
+        }
+
+        switch (_roles[index]) {
+            case SetRole::LEADER_NORMAL:
+                return false;
+            case SetRole::LEADER_BIMODAL:
+                return bimodal_draw();
+            case SetRole::FOLLOWER:
+                break;
+        }
+
+        // Старший бит PSEL: лидеры NORMAL промахиваются чаще - ведомые переходят на BIMODAL
+        bool bimodal = _psel > PSEL_MAX / 2;
+        _last_choice[index] = bimodal ? LastChoice::BIMODAL : LastChoice::NORMAL;
+        ++_follower_fills[bimodal];
+        return bimodal && bimodal_draw();
+    }
+
+    size_t InsertionController::leader_sets(bool bimodal) const {
+        SetRole role = bimodal ? SetRole::LEADER_BIMODAL : SetRole::LEADER_NORMAL;
+        return static_cast<size_t>(std::count(_roles.begin(), _roles.end(), role));
+    }
+
+    size_t InsertionController::follower_sets(bool bimodal) const {
+        LastChoice choice = bimodal ? LastChoice::BIMODAL : LastChoice::NORMAL;
+        return static_cast<size_t>(std::count(_last_choice.begin(), _last_choice.end(), choice));
+    }
+
+    void InsertionController::print_state(std::ostream& out) const {
+        if (_policy != InsertionPolicy::ADAPTIVE) {
+            out << "Insertion: " << (_policy == InsertionPolicy::BIMODAL ? "bimodal" : "normal") << "\n";
+            return;
+        }
+
+        out << "Set dueling: PSEL=" << _psel << "/" << PSEL_MAX
+            << "    leaders normal/bimodal: " << leader_sets(false) << "/" << leader_sets(true)
+            << "    followers normal/bimodal: " << follower_sets(false) << "/" << follower_sets(true)
+            << "    follower fills normal/bimodal: " << _follower_fills[0] << "/" << _follower_fills[1] << "\n";
+
+        if (!_psel_history.empty()) {
+            out << "PSEL every " << SAMPLE_PERIOD << " accesses: ";
+            for (size_t i = 0; i < _psel_history.size(); ++i) {
+                if (i > 0) out << ", ";
+                out << _psel_history[i];
+            }
+            out << "\n";
+        }
+    }
+
+    std::unique_ptr<ReplacementState> make_replacement(ReplacementPolicy policy, size_t sets, size_t ways) {
+        switch (policy) {
+            case ReplacementPolicy::LRU:
+                return std::make_unique<LruPolicy>(sets, ways);
+            case ReplacementPolicy::MRU:
+                return std::make_unique<MruPolicy>(sets, ways);
+            case ReplacementPolicy::RANDOM:
+                return std::make_unique<RandomPolicy>(sets, ways);
+            case ReplacementPolicy::PLRU:
+                return std::make_unique<TreePlruPolicy>(sets, ways);
+            case ReplacementPolicy::NRU:
+                return std::make_unique<NruPolicy>(sets, ways);
+            case ReplacementPolicy::SRRIP:
+                return std::make_unique<RripPolicy>(sets, ways, false);
+            case ReplacementPolicy::BRRIP:
+                return std::make_unique<RripPolicy>(sets, ways, true);
+            case ReplacementPolicy::OPT:
+                return std::make_unique<OptPolicy>(sets, ways);
+        }
+        throw std::invalid_argument("Unknown replacement policy");
+    }
+
+}
@@ -0,0 +1,260 @@
+#include "../include/report.hpp"
+
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace Cache {
+    OutputFormat parse_output_format(std::string_view name) {
+        if (name == "text") return OutputFormat::TEXT;
+        if (name == "csv") return OutputFormat::CSV;
+        if (name == "json") return OutputFormat::JSON;
+        if (name == "none") return OutputFormat::NONE;
+        throw std::invalid_argument("Unknown output format: " + std::string(name));
+    }
+
+    std::shared_ptr<ReportSink> standard_report() {
+        static auto report = std::make_shared<ReportSink>(std::cout);
+        return report;
+    }
+
+    namespace {
+        std::string_view operation_name(Operation operation, bool upper) {
+            if (operation == Operation::READ) return upper ? "READ" : "read";
+            return upper ? "WRITE" : "write";
+        }
+    }
+
+    void ReportSink::values(const int* data, size_t count, std::string_view separator) {
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) _out << separator;
+            _out << data[i];
+        }
+    }
+
+    void ReportSink::json_values(const int* data, size_t count) {
+        _out << '[';
+        values(data, count, ",");
+        _out << ']';
+    }
+
+    // Строка в кавычках: для CSV удваиваются кавычки, для JSON экранируются спецсимволы
+    void ReportSink::quoted(std::string_view text) {
+        _out << '"';
+        for (char c : text) {
+            if (c == '"') {
+                _out << (_format == OutputFormat::CSV ? "\"\"" : "\\\"");
+            } else if (_format == OutputFormat::JSON && c == '\\') {
+                _out << "\\\\";
+            } else if (_format == OutputFormat::JSON && static_cast<unsigned char>(c) < 0x20) {
+                _out << "\\u";
+                _out.hex(static_cast<unsigned char>(c), 4);
+            } else {
+                _out << c;
+            }
+        }
+        _out << '"';
+    }
+
+    void ReportSink::command(std::string_view line) {
+        switch (_format) {
+            case OutputFormat::TEXT:
+                _out << '\n' << line << '\n';
+                break;
+            case OutputFormat::CSV:
+                _out << "command,";
+                quoted(line);
+                _out << '\n';
+                break;
+            case OutputFormat::JSON:
+                _out << "{\"event\":\"command\",\"line\":";
+                quoted(line);
+                _out << "}\n";
+                break;
+            case OutputFormat::NONE:
+                break;
+        }
+    }
+
+    void ReportSink::access(size_t level, const InQuery& query, const OutQuery& result, bool detailed) {
+        const Data* data = detailed ? result.get_data() : nullptr;
+        bool evicted = detailed && result.evicted;
+        uint64_t evicted_tag = result.evicted_tag;
+
+        switch (_format) {
+            case OutputFormat::TEXT:
+                _out << 'L' << level << ": " << operation_name(query.operation, true) << " addr=0x";
+                _out.hex(query.address) << " size=" << query.size << " - " << (result.hit ? "HIT" : "MISS");
+                if (data) {
+                    _out << " data=[";
+                    values(data->buffer.data(), data->valid_count, ", ");
+                    _out << ']';
+                }
+                if (evicted) {
+                    _out << " evicted=0x";
+                    _out.hex(evicted_tag);
+                }
+                _out << '\n';
+                break;
+            case OutputFormat::CSV:
+                _out << "access," << level << ',' << operation_name(query.operation, false) << ",0x";
+                _out.hex(query.address) << ',' << query.size << ',' << (result.hit ? "hit" : "miss") << ',';
+                if (evicted) {
+                    _out << "0x";
+                    _out.hex(evicted_tag);
+                }
+                _out << ',';
+                if (data) values(data->buffer.data(), data->valid_count, " ");
+                _out << '\n';
+                break;
+            case OutputFormat::JSON:
+                _out << "{\"event\":\"access\",\"level\":" << level << ",\"op\":\""
+                     << operation_name(query.operation, false) << "\",\"address\":\"0x";
+                _out.hex(query.address) << "\",\"size\":" << query.size
+                     << ",\"hit\":" << (result.hit ? "true" : "false");
+                if (evicted) {
+                    _out << ",\"evicted_tag\":\"0x";
+                    _out.hex(evicted_tag) << '"';
+                }
+                if (data) {
+                    _out << ",\"data\":";
+                    json_values(data->buffer.data(), data->valid_count);
+                }
+                _out << "}\n";
+                break;
+            case OutputFormat::NONE:
+                break;
+        }
+    }
+
+    void ReportSink::memory_access(const InQuery& query, size_t elements, const int* data, size_t count) {
+        switch (_format) {
+            case OutputFormat::TEXT:
+                _out << "MEM: " << operation_name(query.operation, true) << " addr=0x";
+                _out.hex(query.address) << " size_bits=" << query.size << " (" << elements << " elements)\n";
+                if (data) {
+                    _out << "MEM: WRITE data=[";
+                    values(data, count, ", ");
+                    _out << "]\n";
+                }
+                break;
+            case OutputFormat::CSV:
+                _out << "mem," << operation_name(query.operation, false) << ",0x";
+                _out.hex(query.address) << ',' << query.size << ',' << elements << ',';
+                if (data) values(data, count, " ");
+                _out << '\n';
+                break;
+            case OutputFormat::JSON:
+                _out << "{\"event\":\"mem\",\"op\":\"" << operation_name(query.operation, false) << "\",\"address\":\"0x";
+                _out.hex(query.address) << "\",\"size\":" << query.size << ",\"elements\":" << elements;
+                if (data) {
+                    _out << ",\"data\":";
+                    json_values(data, count);
+                }
+                _out << "}\n";
+                break;
+            case OutputFormat::NONE:
+                break;
+        }
+    }
+
+    void ReportSink::loaded(const Data& data, size_t count) {
+        switch (_format) {
+            case OutputFormat::TEXT:
+                _out << "Data: ";
+                for (size_t i = 0; i < count; ++i) _out << data.buffer[i] << ' ';
+                _out << '\n';
+                break;
+            case OutputFormat::CSV:
+                _out << "data,";
+                values(data.buffer.data(), count, " ");
+                _out << '\n';
+                break;
+            case OutputFormat::JSON:
+                _out << "{\"event\":\"data\",\"data\":";
+                json_values(data.buffer.data(), count);
+                _out << "}\n";
+                break;
+            case OutputFormat::NONE:
+                break;
+        }
+    }
+
+    void ReportSink::begin_blocks(std::string_view title) {
+        if (_format == OutputFormat::TEXT) _out << '\n' << title << "\nAddress | Data\n";
+    }
+
+    void ReportSink::memory_block(uint64_t address, const Data& block) {
+        switch (_format) {
+            case OutputFormat::TEXT:
+                _out << "0x";
+                _out.hex(address, 8) << " | ";
+                values(block.buffer.data(), block.valid_count, ", ");
+                _out << '\n';
+                break;
+            case OutputFormat::CSV:
+                _out << "block,0x";
+                _out.hex(address) << ',';
+                values(block.buffer.data(), block.valid_count, " ");
+                _out << '\n';
+                break;
+            case OutputFormat::JSON:
+                _out << "{\"event\":\"block\",\"address\":\"0x";
+                _out.hex(address) << "\",\"data\":";
+                json_values(block.buffer.data(), block.valid_count);
+                _out << "}\n";
+                break;
+            case OutputFormat::NONE:
+                break;
+        }
+    }
+
+    void ReportSink::cache_block(size_t level, size_t set, size_t way, uint64_t tag, uint64_t address,
+                                 bool dirty, const Data* data) {
+        if (_format == OutputFormat::CSV) {
+            _out << "cache_block," << level << ',' << set << ',' << way << ",0x";
+            _out.hex(tag) << ",0x";
+            _out.hex(address) << ',' << (dirty ? "dirty" : "clean") << ',';
+            if (data) values(data->buffer.data(), data->valid_count, " ");
+            _out << '\n';
+        } else if (_format == OutputFormat::JSON) {
+            _out << "{\"event\":\"cache_block\",\"level\":" << level << ",\"set\":" << set << ",\"way\":" << way
+                 << ",\"tag\":\"0x";
+            _out.hex(tag) << "\",\"address\":\"0x";
+            _out.hex(address) << "\",\"dirty\":" << (dirty ? "true" : "false");
+            if (data) {
+                _out << ",\"data\":";
+                json_values(data->buffer.data(), data->valid_count);
+            }
+            _out << "}\n";
+        }
+    }
+
+    void ReportSink::cache_stats(const std::string& name, const CacheStats& stats) {
+        const uint64_t counters[] = {stats.accesses(), stats.hits(), stats.misses(), stats.reads, stats.read_hits,
+                                     stats.writes, stats.write_hits, stats.fills, stats.evictions,
+                                     stats.dirty_writebacks, stats.write_throughs, stats.bypasses};
+        static constexpr std::string_view names[] = {"accesses", "hits", "misses", "reads", "read_hits",
+                                                     "writes", "write_hits", "fills", "evictions",
+                                                     "dirty_writebacks", "write_throughs", "bypasses"};
+        if (_format == OutputFormat::CSV) {
+            _out << "stats," << name;
+            for (uint64_t counter : counters) _out << ',' << counter;
+            _out << '\n';
+        } else if (_format == OutputFormat::JSON) {
+            _out << "{\"event\":\"stats\",\"name\":";
+            quoted(name);
+            for (size_t i = 0; i < std::size(counters); ++i) _out << ",\"" << names[i] << "\":" << counters[i];
+            _out << "}\n";
+        }
+    }
+
+    void ReportSink::memory_stats(const MemoryStats& stats) {
+        if (_format == OutputFormat::CSV) {
+            _out << "memory_stats," << stats.reads << ',' << stats.writes << '\n';
+        } else if (_format == OutputFormat::JSON) {
+            _out << "{\"event\":\"memory_stats\",\"reads\":" << stats.reads << ",\"writes\":" << stats.writes << "}\n";
+        }
+    }
+}
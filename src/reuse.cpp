@@ -0,0 +1,159 @@
+#include "../include/reuse.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+namespace Cache {
+    void StackDistanceCounter::add(uint64_t position, int32_t delta) {
+        for (uint64_t i = position + 1; i <= _tree.size(); i += i & (~i + 1)) {
+            _tree[i - 1] += delta;
+        }
+    }
+
+    uint64_t StackDistanceCounter::prefix(uint64_t position) const {
+        uint64_t sum = 0;
+        for (uint64_t i = position; i > 0; i -= i & (~i + 1)) {
+            sum += _tree[i - 1];
+        }
+        return sum;
+    }
+
+    // Моменты живых блоков перенумеровываются подряд с сохранением порядка,
+    // дерево строится заново за O(M) с запасом вдвое под новые обращения
+    void StackDistanceCounter::compact() {
+        std::vector<std::pair<uint64_t, uint64_t>> order; // момент, блок
+        order.reserve(_last.size());
+        for (const auto& [block, time] : _last) order.emplace_back(time, block);
+        std::sort(order.begin(), order.end());
+        for (size_t i = 0; i < order.size(); ++i) _last[order[i].second] = i;
+
+        _tree.assign(std::max(MIN_TREE, 2 * order.size()), 0);
+        for (size_t i = 0; i < order.size(); ++i) _tree[i] = 1;
+        for (uint64_t i = 1; i <= _tree.size(); ++i) {
+            uint64_t parent = i + (i & (~i + 1));
+            if (parent <= _tree.size()) _tree[parent - 1] += _tree[i - 1];
+        }
+        _time = order.size();
+    }
+
+    uint64_t StackDistanceCounter::access(uint64_t block) {
+        if (_time == _tree.size()) compact();
+        ++_accesses;
+
+        uint64_t distance = COLD;
+        auto [it, inserted] = _last.try_emplace(block, _time);
+        if (inserted) {
+            ++_cold;
+        } else {
+            distance = prefix(_time) - prefix(it->second + 1);
+            add(it->second, -1);
+            it->second = _time;
+            if (distance >= _histogram.size()) _histogram.resize(distance + 1, 0);
+            ++_histogram[distance];
+        }
+        add(_time, 1);
+        ++_time;
+        return distance;
+    }
+
+    uint64_t StackDistanceCounter::misses(size_t capacity) const {
+        uint64_t misses = _cold;
+        for (size_t d = capacity; d < _histogram.size(); ++d) misses += _histogram[d];
+        return misses;
+    }
+
+    namespace {
+        size_t log2_floor(uint64_t value) {
+            size_t bits = 0;
+            while (value >>= 1) ++bits;
+            return bits;
+        }
+    }
+
+    ReuseAnalyzer::ReuseAnalyzer(uint64_t block_size, const std::vector<size_t>& set_counts)
+        : _block_size(block_size) {
+        for (size_t sets : set_counts) {
+            if (sets == 0 || (sets & (sets - 1)) != 0) {
+                throw std::invalid_argument("Number of sets must be a power of two: " + std::to_string(sets));
+            }
+            AddressLayout layout{log2_floor(block_size), log2_floor(sets)};
+            _variants.push_back({sets, layout, std::vector<StackDistanceCounter>(sets)});
+        }
+    }
+
+    void ReuseAnalyzer::access(uint64_t address) {
+        for (auto& variant : _variants) {
+            variant.stacks[variant.layout.index(address)].access(variant.layout.tag(address));
+        }
+    }
+
+    uint64_t ReuseAnalyzer::misses(size_t sets, size_t ways) const {
+        for (const auto& variant : _variants) {
+            if (variant.sets != sets) continue;
+            uint64_t total = 0;
+            for (const auto& stack : variant.stacks) total += stack.misses(ways);
+            return total;
+        }
+        throw std::invalid_argument("No curve for " + std::to_string(sets) + " sets");
+    }
+
+    uint64_t ReuseAnalyzer::accesses() const {
+        uint64_t total = 0;
+        if (!_variants.empty()) {
+            for (const auto& stack : _variants.front().stacks) total += stack.accesses();
+        }
+        return total;
+    }
+
+    std::vector<uint64_t> ReuseAnalyzer::merged_histogram(const Variant& variant, uint64_t& cold) {
+        std::vector<uint64_t> histogram;
+        cold = 0;
+        for (const auto& stack : variant.stacks) {
+            cold += stack.cold_misses();
+            const auto& h = stack.histogram();
+            if (h.size() > histogram.size()) histogram.resize(h.size(), 0);
+            for (size_t d = 0; d < h.size(); ++d) histogram[d] += h[d];
+        }
+        return histogram;
+    }
+
+    void ReuseAnalyzer::write_curves_csv(std::ostream& out, size_t max_ways) const {
+        out << "sets,ways,capacity,accesses,misses,miss_ratio\n";
+        uint64_t total = accesses();
+        for (const auto& variant : _variants) {
+            // Промахи при ways путях - холодные плюс расстояния >= ways
+            uint64_t cold = 0;
+            std::vector<uint64_t> histogram = merged_histogram(variant, cold);
+            std::vector<uint64_t> beyond(histogram.size() + 1, 0); // обращений с расстоянием >= d
+            for (size_t d = histogram.size(); d > 0; --d) beyond[d - 1] = beyond[d] + histogram[d - 1];
+
+            auto row = [&](size_t ways) {
+                uint64_t misses = cold + (ways < beyond.size() ? beyond[ways] : 0);
+                out << variant.sets << "," << ways << "," << variant.sets * ways * _block_size << ","
+                    << total << "," << misses << "," << std::fixed << std::setprecision(6)
+                    << (total ? static_cast<double>(misses) / total : 0.0) << std::defaultfloat << "\n";
+            };
+            if (variant.sets > 1) {
+                for (size_t ways = 1; ways <= max_ways; ++ways) row(ways);
+                continue;
+            }
+            for (size_t ways = 1;; ways *= 2) {
+                row(ways);
+                if (ways >= histogram.size()) break;
+            }
+        }
+    }
+
+    void ReuseAnalyzer::write_histogram_csv(std::ostream& out) const {
+        out << "sets,distance,count\n";
+        for (const auto& variant : _variants) {
+            uint64_t cold = 0;
+            std::vector<uint64_t> histogram = merged_histogram(variant, cold);
+            for (size_t d = 0; d < histogram.size(); ++d) {
+                if (histogram[d]) out << variant.sets << "," << d << "," << histogram[d] << "\n";
+            }
+            out << variant.sets << ",cold," << cold << "\n";
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include "memory.hpp"
+#include "reuse.hpp"
+#include "sweep.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+
+using namespace Cache;
+namespace po = boost::program_options;
+
+// Кривые промахов LRU для всех ёмкостей и ассоциативностей за один проход по
+// трассе вместо отдельного прогона Cache на каждый размер
+namespace {
+    std::vector<size_t> parse_sets(std::string_view text) {
+        std::vector<size_t> sets;
+        while (!text.empty()) {
+            size_t comma = text.find(',');
+            sets.push_back(static_cast<size_t>(parse_amount("sets", text.substr(0, comma))));
+            text.remove_prefix(comma == std::string_view::npos ? text.size() : comma + 1);
+        }
+        if (sets.empty()) throw std::invalid_argument("Empty list for --sets");
+        return sets;
+    }
+
+    bool write_to(const po::variables_map& vm, const char* key, const std::function<void(std::ostream&)>& write) {
+        if (!vm.count(key)) {
+            write(std::cout);
+            return true;
+        }
+        std::ofstream out(vm[key].as<std::string>());
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot open output file: " << vm[key].as<std::string>() << std::endl;
+            return false;
+        }
+        write(out);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    po::options_description desc("Reuse Distance Options");
+    desc.add_options()
+        ("help,h", "Show help message")
+        ("test", po::value<std::string>(), "Trace file")
+        ("format", po::value<std::string>()->default_value("native"), "Trace format (native, din, lackey, champsim)")
+        ("gen", po::value<std::string>(), "Synthetic workload instead of a trace, as in model1 --gen")
+        ("block", po::value<std::string>()->default_value("64"), "Block size")
+        ("sets", po::value<std::string>()->default_value("1,64,1K"),
+         "Numbers of sets; 1 is a fully associative cache")
+        ("max-ways", po::value<size_t>()->default_value(16), "Largest associativity reported for set-associative curves")
+        ("histogram", po::value<std::string>(), "Also write the distance histogram to this CSV file")
+        ("output,o", po::value<std::string>(), "CSV file (default stdout)");
+
+    po::variables_map vm;
+    try {
+        vm = parse_command_line_args(argc, argv, desc);
+    } catch (const po::error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (handle_help_option(vm, desc)) {
+        return 0;
+    }
+    if (vm.count("test") == vm.count("gen")) {
+        std::cerr << "Error: exactly one of --test and --gen is required" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<ReuseAnalyzer> analyzer;
+    std::vector<SweepAccess> trace;
+    try {
+        uint64_t block = parse_amount("block", vm["block"].as<std::string>());
+        if (block == 0 || (block & (block - 1)) != 0) {
+            throw std::invalid_argument("Block size must be a power of two");
+        }
+        analyzer = std::make_unique<ReuseAnalyzer>(block, parse_sets(vm["sets"].as<std::string>()));
+        trace = vm.count("gen") ? load_sweep_trace(parse_workload_spec(vm["gen"].as<std::string>()))
+                                : load_sweep_trace(vm["test"].as<std::string>(), get_trace_format(vm));
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (const SweepAccess& access : trace) analyzer->access(access.address);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << trace.size() << " accesses analyzed in " << elapsed.count() << " s" << std::endl;
+
+    size_t max_ways = vm["max-ways"].as<size_t>();
+    bool ok = write_to(vm, "output", [&](std::ostream& out) { analyzer->write_curves_csv(out, max_ways); });
+    if (ok && vm.count("histogram")) {
+        ok = write_to(vm, "histogram", [&](std::ostream& out) { analyzer->write_histogram_csv(out); });
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#include "../include/static_cache.hpp"
+
+namespace Cache {
+    namespace {
+        // Конфигурации из model1.cpp и model2.cpp
+        using Model1L1 = StaticCache<4 * 1024, 64, 4,
+            WritePolicy::WRITE_BACK, AllocationPolicy::READ_ALLOCATE, ReplacementPolicy::LRU>;
+        using Model2L1 = StaticCache<16 * 1024, 32, 4,
+            WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::MRU>;
+        using Model2L2 = StaticCache<256, 32, 256 / 32,
+            WritePolicy::WRITE_THROUGH, AllocationPolicy::WRITE_ALLOCATE, ReplacementPolicy::LRU>;
+
+        template <typename First, typename... Rest>
+        std::shared_ptr<Cache> make_static_cache(size_t size, uint64_t block_size, size_t associativity, uint64_t address_bits,
+                                                 WritePolicy wp, AllocationPolicy ap, ReplacementPolicy rp) {
+            if (First::matches(size, block_size, associativity, wp, ap, rp)) {
+                return std::make_shared<First>(address_bits);
+            }
+            if constexpr (sizeof...(Rest) > 0) {
+                return make_static_cache<Rest...>(size, block_size, associativity, address_bits, wp, ap, rp);
+            } else {
+                return nullptr;
+            }
+        }
+    }
+
+    std::shared_ptr<Cache> make_cache(size_t size, uint64_t block_size, size_t associativity, uint64_t address_bits,
+                                      WritePolicy wp, AllocationPolicy ap, ReplacementPolicy rp) {
+        auto cache = make_static_cache<Model1L1, Model2L1, Model2L2>(
+            size, block_size, associativity, address_bits, wp, ap, rp);
+        if (cache) {
+            return cache;
+        }
+        return std::make_shared<Cache>(size, block_size, associativity, address_bits, wp, ap, rp);
+    }
+}
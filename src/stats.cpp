@@ -0,0 +1,36 @@
+#include "../include/stats.hpp"
+
+#include <iomanip>
+#include <ostream>
+
+namespace Cache {
+    namespace {
+        double percent(uint64_t part, uint64_t total) {
+            return total ? 100.0 * static_cast<double>(part) / total : 0.0;
+        }
+    }
+
+    void CacheStats::print(std::ostream& out, const std::string& name, bool per_set) const {
+        out << name << ": accesses=" << accesses()
+            << " hits=" << hits() << " misses=" << misses()
+            << " hit rate=" << std::fixed << std::setprecision(2) << percent(hits(), accesses()) << "%"
+            << std::defaultfloat << "\n"
+            << "  reads=" << reads << " (hits " << read_hits << ", misses " << read_misses() << ")"
+            << "  writes=" << writes << " (hits " << write_hits << ", misses " << write_misses() << ")\n"
+            << "  fills=" << fills << " evictions=" << evictions
+            << " dirty writebacks=" << dirty_writebacks
+            << " write-throughs=" << write_throughs
+            << " bypasses=" << bypasses << "\n";
+
+        if (!per_set) return;
+        for (size_t set = 0; set < set_accesses.size(); ++set) {
+            if (set_accesses[set] == 0) continue;
+            out << "  Set #" << set << ": accesses=" << set_accesses[set]
+                << " misses=" << set_misses[set] << "\n";
+        }
+    }
+
+    void MemoryStats::print(std::ostream& out) const {
+        out << "Memory: reads=" << reads << " writes=" << writes << "\n";
+    }
+}
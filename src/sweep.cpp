@@ -0,0 +1,282 @@
+#include "../include/sweep.hpp"
+#include "../include/parallel_cache.hpp"
+#include "../include/static_cache.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace Cache {
+    namespace {
+        constexpr size_t BATCH = 256;
+        constexpr size_t PARTITIONED_BATCH = 1 << 14; // потоки SetPartitionedCache синхронизируются на каждый пакет
+
+        bool is_power_of_two(uint64_t value) { return value && !(value & (value - 1)); }
+
+        const char* write_policy_name(WritePolicy policy) {
+            return policy == WritePolicy::WRITE_BACK ? "wb" : "wt";
+        }
+
+        const char* alloc_policy_name(AllocationPolicy policy) {
+            switch (policy) {
+                case AllocationPolicy::READ_ALLOCATE: return "read";
+                case AllocationPolicy::WRITE_ALLOCATE: return "write";
+                case AllocationPolicy::BOTH: return "both";
+            }
+            return "?";
+        }
+
+        void expand(const SweepAccess& access, InQuery& query) {
+            query.operation = access.operation;
+            query.address = access.address;
+            query.size = access.size;
+            query.data.valid_count = access.operation == Operation::WRITE
+                ? std::min<size_t>((access.size + sizeof(int) - 1) / sizeof(int), Data::SIZE) : 0;
+        }
+
+        SweepResult run_partitioned(const SweepConfig& config, uint64_t address_bits,
+                                    const std::vector<SweepAccess>& trace, size_t threads) {
+            SetPartitionedCache cache(config.size, config.block_size, config.associativity, address_bits,
+                                      config.write_policy, config.alloc_policy, config.replacement,
+                                      InsertionPolicy::NORMAL, threads);
+            cache.set_data_mode(DataMode::TAGS_ONLY);
+
+            std::vector<InQuery> queries(std::min(PARTITIONED_BATCH, trace.size()));
+            std::vector<OutQuery> results(queries.size());
+            auto start = std::chrono::steady_clock::now();
+            for (size_t first = 0; first < trace.size(); first += PARTITIONED_BATCH) {
+                size_t count = std::min(PARTITIONED_BATCH, trace.size() - first);
+                for (size_t i = 0; i < count; ++i) expand(trace[first + i], queries[i]);
+                cache.query_batch(queries.data(), count, results.data());
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            CacheStats stats = cache.get_stats();
+            stats.set_accesses.clear();
+            stats.set_misses.clear();
+            return SweepResult{config, {std::move(stats)}, cache.get_memory_stats(), elapsed.count()};
+        }
+
+        bool is_valid_level(size_t size, uint64_t block_size, size_t associativity, ReplacementPolicy replacement) {
+            if (!is_power_of_two(block_size) || associativity == 0 || size % (block_size * associativity) != 0) {
+                return false;
+            }
+            if (replacement == ReplacementPolicy::PLRU && !is_power_of_two(associativity)) return false;
+            return is_power_of_two(size / (block_size * associativity));
+        }
+    }
+
+    AccessReader::AccessReader(const std::string& path, TraceFormat format) : _path(path) {
+        if (format != TraceFormat::NATIVE) {
+            _imported = std::make_unique<ImportedTraceReader>(path, format);
+            return;
+        }
+        _file = std::make_unique<MappedFile>(path);
+        if (is_binary_trace(_file->data(), _file->size())) {
+            _binary = std::make_unique<BinaryTraceReader>(_file->data(), _file->size());
+        } else {
+            _text = std::make_unique<TextTraceReader>(_file->data(), _file->size());
+        }
+    }
+
+    AccessReader::AccessReader(const WorkloadSpec& spec)
+        : _generator(std::make_unique<WorkloadGenerator>(spec)), _remaining(spec.count) {}
+
+    bool AccessReader::next(SweepAccess& access) {
+        auto is_access = [](const TraceRecord& r) {
+            return r.command == TraceCommand::LOAD || r.command == TraceCommand::STORE;
+        };
+        if (_generator) {
+            if (_remaining == 0) return false;
+            --_remaining;
+            _generator->next(_record.query);
+        } else if (_imported) {
+            if (!_imported->next(_record)) return false;
+        } else if (_binary) {
+            do {
+                if (!_binary->next(_record)) return false;
+            } while (!is_access(_record));
+        } else {
+            std::string_view line;
+            while (true) {
+                if (!_text->next_line(line)) return false;
+                if (parse_trace_line(line, _record, _error)) {
+                    if (is_access(_record)) break;
+                } else if (!_error.empty()) {
+                    std::cerr << _path << ":" << _text->line_number() << ": " << _error << std::endl;
+                }
+            }
+        }
+        access = {_record.query.address, static_cast<uint32_t>(_record.query.size), _record.query.operation};
+        return true;
+    }
+
+    std::vector<SweepAccess> load_sweep_trace(const std::string& path, TraceFormat format) {
+        std::vector<SweepAccess> trace;
+        AccessReader reader(path, format);
+        SweepAccess access;
+        while (reader.next(access)) trace.push_back(access);
+        return trace;
+    }
+
+    std::vector<SweepAccess> load_sweep_trace(const WorkloadSpec& spec) {
+        std::vector<SweepAccess> trace;
+        trace.reserve(spec.count);
+        AccessReader reader(spec);
+        SweepAccess access;
+        while (reader.next(access)) trace.push_back(access);
+        return trace;
+    }
+
+    bool is_valid_config(const SweepConfig& config) {
+        if (!is_valid_level(config.size, config.block_size, config.associativity, config.replacement)) return false;
+        return config.levels == 1 ||
+               (config.levels == 2 &&
+                is_valid_level(config.l2_size, config.block_size, config.l2_associativity, config.replacement));
+    }
+
+    std::vector<SweepConfig> SweepGrid::expand() const {
+        std::vector<SweepConfig> configs;
+        for (size_t level_count : levels) {
+            // Для одного уровня списки L2 не перебираются
+            std::vector<size_t> l2_size_list = level_count > 1 ? l2_sizes : std::vector<size_t>{0};
+            std::vector<size_t> l2_way_list = level_count > 1 ? l2_associativities : std::vector<size_t>{0};
+            for (size_t size : sizes)
+            for (uint64_t block_size : block_sizes)
+            for (size_t ways : associativities)
+            for (WritePolicy wp : write_policies)
+            for (AllocationPolicy ap : alloc_policies)
+            for (ReplacementPolicy rp : replacements)
+            for (size_t l2_size : l2_size_list)
+            for (size_t l2_ways : l2_way_list) {
+                SweepConfig config{size, block_size, ways, wp, ap, rp, level_count, l2_size, l2_ways};
+                if (is_valid_config(config)) configs.push_back(config);
+            }
+        }
+        return configs;
+    }
+
+    SweepResult run_sweep_config(const SweepConfig& config, uint64_t address_bits,
+                                 const std::vector<SweepAccess>& trace, size_t threads) {
+        if (threads > 1 && config.levels == 1 &&
+            SetPartitionedCache::sets_independent(config.replacement, InsertionPolicy::NORMAL)) {
+            return run_partitioned(config, address_bits, trace, threads);
+        }
+        std::vector<std::shared_ptr<Cache>> caches{
+            make_cache(config.size, config.block_size, config.associativity, address_bits,
+                       config.write_policy, config.alloc_policy, config.replacement)};
+        if (config.levels > 1) {
+            caches.push_back(make_cache(config.l2_size, config.block_size, config.l2_associativity, address_bits,
+                                        config.write_policy, config.alloc_policy, config.replacement));
+        }
+        MemoryHierarchy hierarchy(caches, std::make_shared<MemoryModel>(), TraceLevel::NONE, DataMode::TAGS_ONLY);
+
+        std::vector<InQuery> queries(BATCH);
+        std::vector<OutQuery> results(BATCH);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t first = 0; first < trace.size(); first += BATCH) {
+            size_t count = std::min(BATCH, trace.size() - first);
+            for (size_t i = 0; i < count; ++i) expand(trace[first + i], queries[i]);
+            hierarchy.query_batch(queries.data(), count, results.data());
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        SweepResult result{config, {}, hierarchy.get_memory_stats(), elapsed.count()};
+        for (size_t level = 0; level < hierarchy.levels(); ++level) {
+            CacheStats stats = hierarchy.get_level_stats(level);
+            stats.set_accesses.clear();
+            stats.set_misses.clear();
+            result.levels.push_back(std::move(stats));
+        }
+        return result;
+    }
+
+    // Конфигурации раздаются через общий счётчик: долгие и короткие прогоны
+    // сами выравниваются по потокам
+    std::vector<SweepResult> run_sweep(const std::vector<SweepConfig>& configs, uint64_t address_bits,
+                                       const std::vector<SweepAccess>& trace, size_t threads) {
+        std::vector<SweepResult> results(configs.size());
+        size_t threads_per_config = configs.empty() ? 1 : std::max<size_t>(1, threads / configs.size());
+        std::atomic<size_t> next{0};
+        std::exception_ptr failure;
+        std::atomic<bool> failed{false};
+
+        auto worker = [&] {
+            for (size_t i = next++; i < configs.size() && !failed; i = next++) {
+                try {
+                    results[i] = run_sweep_config(configs[i], address_bits, trace, threads_per_config);
+                } catch (...) {
+                    if (!failed.exchange(true)) failure = std::current_exception();
+                }
+            }
+        };
+
+        threads = std::max<size_t>(1, std::min(threads, configs.size()));
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& thread : pool) thread.join();
+
+        if (failure) std::rethrow_exception(failure);
+        return results;
+    }
+
+    void write_sweep_csv(std::ostream& out, const std::vector<SweepResult>& results) {
+        out << "size,block,ways,write,alloc,replacement,levels,l2_size,l2_ways,accesses,"
+               "l1_hits,l1_misses,l1_hit_rate,l2_hits,l2_misses,l2_hit_rate,"
+               "dirty_writebacks,memory_reads,memory_writes,seconds\n";
+        for (const auto& r : results) {
+            const SweepConfig& c = r.config;
+            const CacheStats& l1 = r.levels.front();
+            CacheStats l2 = r.levels.size() > 1 ? r.levels[1] : CacheStats();
+            uint64_t writebacks = 0;
+            for (const auto& level : r.levels) writebacks += level.dirty_writebacks;
+            out << c.size << "," << c.block_size << "," << c.associativity << ","
+                << write_policy_name(c.write_policy) << "," << alloc_policy_name(c.alloc_policy) << ","
+                << replacement_policy_name(c.replacement) << "," << c.levels << ","
+                << c.l2_size << "," << c.l2_associativity << ","
+                << l1.accesses() << "," << l1.hits() << "," << l1.misses() << ","
+                << std::fixed << std::setprecision(6) << l1.hit_rate() << ","
+                << l2.hits() << "," << l2.misses() << "," << l2.hit_rate() << ","
+                << std::defaultfloat << writebacks << "," << r.memory.reads << "," << r.memory.writes << ","
+                << std::fixed << std::setprecision(4) << r.seconds << std::defaultfloat << "\n";
+        }
+    }
+
+    const char* replacement_policy_name(ReplacementPolicy policy) {
+        switch (policy) {
+            case ReplacementPolicy::LRU: return "lru";
+            case ReplacementPolicy::MRU: return "mru";
+            case ReplacementPolicy::RANDOM: return "random";
+            case ReplacementPolicy::PLRU: return "plru";
+            case ReplacementPolicy::NRU: return "nru";
+            case ReplacementPolicy::SRRIP: return "srrip";
+            case ReplacementPolicy::BRRIP: return "brrip";
+            case ReplacementPolicy::OPT: return "opt";
+        }
+        return "?";
+    }
+
+    WritePolicy parse_write_policy(std::string_view name) {
+        if (name == "wb") return WritePolicy::WRITE_BACK;
+        if (name == "wt") return WritePolicy::WRITE_THROUGH;
+        throw std::invalid_argument("Unknown write policy: " + std::string(name));
+    }
+
+    AllocationPolicy parse_alloc_policy(std::string_view name) {
+        if (name == "read") return AllocationPolicy::READ_ALLOCATE;
+        if (name == "write") return AllocationPolicy::WRITE_ALLOCATE;
+        if (name == "both") return AllocationPolicy::BOTH;
+        throw std::invalid_argument("Unknown allocation policy: " + std::string(name));
+    }
+
+    ReplacementPolicy parse_replacement_policy(std::string_view name) {
+        for (ReplacementPolicy policy : {ReplacementPolicy::LRU, ReplacementPolicy::MRU, ReplacementPolicy::RANDOM,
+                                         ReplacementPolicy::PLRU, ReplacementPolicy::NRU, ReplacementPolicy::SRRIP,
+                                         ReplacementPolicy::BRRIP}) {
+            if (name == replacement_policy_name(policy)) return policy;
+        }
+        throw std::invalid_argument("Unknown replacement policy: " + std::string(name));
+    }
+}
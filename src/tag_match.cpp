@@ -0,0 +1,72 @@
+#include "../include/tag_match.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CACHE_TAG_MATCH_X86 1
+#endif
+
+namespace Cache {
+
+    uint64_t tag_match_mask_scalar(const uint64_t* tags, size_t ways, uint64_t tag) {
+        uint64_t mask = 0;
+        for (size_t way = 0; way < ways; ++way) {
+            mask |= static_cast<uint64_t>(tags[way] == tag) << way;
+        }
+        return mask;
+    }
+
+#ifdef CACHE_TAG_MATCH_X86
+    // 4 тега за сравнение, movemask_pd даёт по биту на 64-битную дорожку
+    __attribute__((target("avx2")))
+    static uint64_t tag_match_mask_avx2(const uint64_t* tags, size_t ways, uint64_t tag) {
+        const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(tag));
+        uint64_t mask = 0;
+        size_t way = 0;
+        for (; way + 4 <= ways; way += 4) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + way));
+            __m256i eq = _mm256_cmpeq_epi64(chunk, needle);
+            mask |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(eq))) << way;
+        }
+        for (; way < ways; ++way) {
+            mask |= static_cast<uint64_t>(tags[way] == tag) << way;
+        }
+        return mask;
+    }
+
+    __attribute__((target("sse4.2")))
+    static uint64_t tag_match_mask_sse42(const uint64_t* tags, size_t ways, uint64_t tag) {
+        const __m128i needle = _mm_set1_epi64x(static_cast<long long>(tag));
+        uint64_t mask = 0;
+        size_t way = 0;
+        for (; way + 2 <= ways; way += 2) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + way));
+            __m128i eq = _mm_cmpeq_epi64(chunk, needle);
+            mask |= static_cast<uint64_t>(_mm_movemask_pd(_mm_castsi128_pd(eq))) << way;
+        }
+        for (; way < ways; ++way) {
+            mask |= static_cast<uint64_t>(tags[way] == tag) << way;
+        }
+        return mask;
+    }
+#endif
+
+    static TagMatchFn select_tag_match() {
+#ifdef CACHE_TAG_MATCH_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return tag_match_mask_avx2;
+        if (__builtin_cpu_supports("sse4.2")) return tag_match_mask_sse42;
+#endif
+        return tag_match_mask_scalar;
+    }
+
+    const TagMatchFn tag_match_mask = select_tag_match();
+
+    const char* tag_match_isa() {
+#ifdef CACHE_TAG_MATCH_X86
+        if (tag_match_mask == tag_match_mask_avx2) return "avx2";
+        if (tag_match_mask == tag_match_mask_sse42) return "sse4.2";
+#endif
+        return "scalar";
+    }
+
+}
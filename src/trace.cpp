@@ -0,0 +1,236 @@
+#include "../include/trace.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Cache {
+    namespace {
+        bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+        // Следующее слово строки; пустое - слова кончились
+        std::string_view next_token(std::string_view& rest) {
+            size_t begin = 0;
+            while (begin < rest.size() && is_blank(rest[begin])) ++begin;
+            size_t end = begin;
+            while (end < rest.size() && !is_blank(rest[end])) ++end;
+            std::string_view token = rest.substr(begin, end - begin);
+            rest.remove_prefix(end);
+            return token;
+        }
+
+        template <typename T>
+        bool parse_number(std::string_view token, T& value, int base) {
+            if (base == 16 && token.size() > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X')) {
+                token.remove_prefix(2);
+            }
+            if (token.empty()) return false;
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value, base);
+            return ec == std::errc() && ptr == token.data() + token.size();
+        }
+    }
+
+    bool parse_trace_line(std::string_view line, TraceRecord& record, std::string& error) {
+        error.clear();
+        std::string_view rest = line;
+        std::string_view op = next_token(rest);
+        if (op.empty()) {
+            return false;
+        }
+        if (op == "show" || op == "stats") {
+            record.command = op == "show" ? TraceCommand::SHOW : TraceCommand::STATS;
+            return true;
+        }
+        if (op != "ld" && op != "st") {
+            error = "Invalid command format";
+            return false;
+        }
+
+        InQuery& query = record.query;
+        if (!parse_number(next_token(rest), query.size, 10) ||
+            !parse_number(next_token(rest), query.address, 16)) {
+            error = "Invalid command format";
+            return false;
+        }
+
+        Data& data = query.data;
+        data.valid_count = 0;
+        if (op == "ld") {
+            record.command = TraceCommand::LOAD;
+            query.operation = Operation::READ;
+            return true;
+        }
+
+        size_t expected_values = query.size / sizeof(int);
+        size_t count = 0;
+        for (std::string_view token = next_token(rest); !token.empty(); token = next_token(rest), ++count) {
+            uint32_t value;
+            if (!parse_number(token, value, 16)) {
+                error = "Invalid value format: " + std::string(token);
+                return false;
+            }
+            if (count < Data::SIZE) data.buffer[count] = static_cast<int>(value);
+        }
+        if (count != expected_values || count > Data::SIZE) {
+            error = "Size mismatch. Expected " + std::to_string(expected_values) +
+                    " values, got " + std::to_string(count) + " values";
+            return false;
+        }
+        std::fill(data.buffer.begin() + count, data.buffer.end(), 0);
+        data.valid_count = count;
+
+        record.command = TraceCommand::STORE;
+        query.operation = Operation::WRITE;
+        return true;
+    }
+
+    bool TextTraceReader::next_line(std::string_view& line) {
+        if (_pos == _end) return false;
+        const char* newline = static_cast<const char*>(std::memchr(_pos, '\n', _end - _pos));
+        const char* line_end = newline ? newline : _end;
+        line = std::string_view(_pos, line_end - _pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        _pos = newline ? newline + 1 : _end;
+        ++_line_number;
+        return true;
+    }
+
+    MappedFile::MappedFile(const std::string& path, MapAccess access) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file: " + path);
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size > 0) {
+            bool writable = access == MapAccess::COPY_ON_WRITE;
+            void* mapped = ::mmap(nullptr, _size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file: " + path);
+            }
+            ::madvise(mapped, _size, writable ? MADV_RANDOM : MADV_SEQUENTIAL);
+            _data = static_cast<uint8_t*>(mapped);
+        }
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (_data) {
+            ::munmap(_data, _size);
+        }
+    }
+
+    bool is_binary_trace(const uint8_t* data, size_t size) {
+        return size >= BINARY_TRACE_HEADER_SIZE &&
+               std::memcmp(data, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) == 0;
+    }
+
+    BinaryTraceReader::BinaryTraceReader(const uint8_t* data, size_t size)
+        : _pos(data), _end(data + size) {
+        if (!is_binary_trace(data, size)) {
+            throw std::runtime_error("Not a binary trace");
+        }
+        if (data[sizeof(BINARY_TRACE_MAGIC)] != BINARY_TRACE_VERSION) {
+            throw std::runtime_error("Unsupported binary trace version");
+        }
+        _pos += BINARY_TRACE_HEADER_SIZE;
+    }
+
+    uint64_t BinaryTraceReader::read_varint() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (_pos == _end) break;
+            uint8_t byte = *_pos++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Corrupted binary trace: truncated varint");
+    }
+
+    bool BinaryTraceReader::next(TraceRecord& record) {
+        if (_pos == _end) return false;
+
+        uint8_t command = *_pos++;
+        if (command > static_cast<uint8_t>(TraceCommand::STATS)) {
+            throw std::runtime_error("Corrupted binary trace: unknown record type");
+        }
+        record.command = static_cast<TraceCommand>(command);
+        if (record.command == TraceCommand::SHOW || record.command == TraceCommand::STATS) {
+            return true;
+        }
+
+        InQuery& query = record.query;
+        query.size = read_varint();
+        uint64_t delta = read_varint();
+        _prev_address += (delta >> 1) ^ (~(delta & 1) + 1); // zigzag
+        query.address = _prev_address;
+        query.data.valid_count = 0;
+
+        if (record.command == TraceCommand::LOAD) {
+            query.operation = Operation::READ;
+            return true;
+        }
+
+        query.operation = Operation::WRITE;
+        uint64_t count = read_varint();
+        if (count > Data::SIZE || static_cast<uint64_t>(_end - _pos) < count * sizeof(uint32_t)) {
+            throw std::runtime_error("Corrupted binary trace: bad store payload");
+        }
+        for (size_t i = 0; i < count; ++i, _pos += sizeof(uint32_t)) {
+            query.data.buffer[i] = static_cast<int>(uint32_t{_pos[0]} | uint32_t{_pos[1]} << 8 |
+                                                    uint32_t{_pos[2]} << 16 | uint32_t{_pos[3]} << 24);
+        }
+        std::fill(query.data.buffer.begin() + count, query.data.buffer.end(), 0);
+        query.data.valid_count = count;
+        return true;
+    }
+
+    BinaryTraceWriter::BinaryTraceWriter(std::ostream& out) : _out(out) {
+        char header[BINARY_TRACE_HEADER_SIZE] = {};
+        std::memcpy(header, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC));
+        header[sizeof(BINARY_TRACE_MAGIC)] = static_cast<char>(BINARY_TRACE_VERSION);
+        _out.write(header, sizeof(header));
+    }
+
+    void BinaryTraceWriter::write_varint(uint64_t value) {
+        while (value >= 0x80) {
+            _out.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        _out.put(static_cast<char>(value));
+    }
+
+    void BinaryTraceWriter::write(const TraceRecord& record) {
+        _out.put(static_cast<char>(record.command));
+        if (record.command == TraceCommand::SHOW || record.command == TraceCommand::STATS) {
+            return;
+        }
+
+        const InQuery& query = record.query;
+        int64_t delta = static_cast<int64_t>(query.address - _prev_address);
+        _prev_address = query.address;
+        write_varint(query.size);
+        write_varint((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)); // zigzag
+
+        if (record.command == TraceCommand::STORE) {
+            size_t count = std::min(query.data.valid_count, Data::SIZE);
+            write_varint(count);
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t value = static_cast<uint32_t>(query.data.buffer[i]);
+                char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8),
+                                 static_cast<char>(value >> 16), static_cast<char>(value >> 24)};
+                _out.write(bytes, sizeof(bytes));
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include "trace.hpp"
+
+#include <fstream>
+#include <memory>
+
+using namespace Cache;
+
+// Перевод текстовой трассы (ld/st/show/stats) в двоичный формат для --test
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.bin>" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<MappedFile> in;
+    try {
+        in = std::make_unique<MappedFile>(argv[1]);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    std::ofstream out(argv[2], std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open output file: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    BinaryTraceWriter writer(out);
+    TextTraceReader reader(in->data(), in->size());
+    TraceRecord record;
+    std::string_view line;
+    std::string error;
+    size_t records = 0, skipped = 0;
+    while (reader.next_line(line)) {
+        if (parse_trace_line(line, record, error)) {
+            writer.write(record);
+            ++records;
+        } else if (!error.empty()) {
+            std::cerr << argv[1] << ":" << reader.line_number() << ": " << error << std::endl;
+            ++skipped;
+        }
+    }
+
+    if (!out) {
+        std::cerr << "Error: Write failed: " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << records << " records written, " << skipped << " lines skipped" << std::endl;
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include "event_trace.hpp"
+#include "memory.hpp"
+#include "report.hpp"
+
+using namespace Cache;
+namespace po = boost::program_options;
+
+// Перевод двоичной трассы событий (--event-trace) в строки трассы --trace,
+// а также в CSV или JSON; данных блоков в трассе событий нет
+int main(int argc, char* argv[]) {
+    po::options_description desc("Event Trace Decoder Options");
+    desc.add_options()
+        ("help,h", "Show help message")
+        ("input", po::value<std::string>(), "Event trace written with --event-trace")
+        ("trace,t", po::value<int>()->default_value(2),
+         "Trace level to print (1=cache levels, 2=also evicted tags and memory accesses)")
+        ("thread", po::value<uint32_t>(), "Only events of this recording thread")
+        ("output-format", po::value<std::string>()->default_value("text"), "text, csv or json");
+    po::positional_options_description positional;
+    positional.add("input", 1);
+
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+        po::notify(vm);
+    } catch (const po::error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (handle_help_option(vm, desc)) {
+        return 0;
+    }
+    if (!vm.count("input")) {
+        std::cerr << "Error: event trace file is required" << std::endl;
+        return 1;
+    }
+
+    TraceLevel level = vm["trace"].as<int>() >= 2 ? TraceLevel::FULL : TraceLevel::BASIC;
+    try {
+        OutputFormat format = parse_output_format(vm["output-format"].as<std::string>());
+        ReportSink report(std::cout, format);
+        EventLogReader reader(vm["input"].as<std::string>());
+        uint32_t thread;
+        TraceEvent event;
+        while (reader.next(thread, event)) {
+            if (vm.count("thread") && thread != vm["thread"].as<uint32_t>()) continue;
+            report_event(report, event, level);
+        }
+        report.flush();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,314 @@
+#include "../include/trace_import.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <lzma.h>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace Cache {
+    namespace {
+        constexpr uint8_t GZIP_MAGIC[2] = {0x1F, 0x8B};
+        constexpr uint8_t XZ_MAGIC[6] = {0xFD, '7', 'z', 'X', 'Z', 0x00};
+        constexpr size_t INPUT_PIECE = 1 << 30; // avail_in у zlib 32-битный
+
+        bool starts_with(const uint8_t* data, size_t size, const uint8_t* magic, size_t magic_size) {
+            return size >= magic_size && std::memcmp(data, magic, magic_size) == 0;
+        }
+
+        bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+        std::string_view next_token(std::string_view& rest, char separator = ' ') {
+            size_t begin = 0;
+            while (begin < rest.size() && is_blank(rest[begin])) ++begin;
+            size_t end = begin;
+            while (end < rest.size() && !is_blank(rest[end]) && rest[end] != separator) ++end;
+            std::string_view token = rest.substr(begin, end - begin);
+            rest.remove_prefix(end < rest.size() && rest[end] == separator ? end + 1 : end);
+            return token;
+        }
+
+        template <typename T>
+        bool parse_number(std::string_view token, T& value, int base) {
+            if (base == 16 && token.size() > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X')) {
+                token.remove_prefix(2);
+            }
+            if (token.empty()) return false;
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value, base);
+            return ec == std::errc() && ptr == token.data() + token.size();
+        }
+
+        uint64_t load_le64(const uint8_t* bytes) {
+            uint64_t value = 0;
+            for (size_t i = 0; i < 8; ++i) value |= uint64_t{bytes[i]} << (8 * i);
+            return value;
+        }
+    }
+
+    TraceFormat parse_trace_format(const std::string& name) {
+        if (name == "native") return TraceFormat::NATIVE;
+        if (name == "din") return TraceFormat::DINERO;
+        if (name == "lackey") return TraceFormat::LACKEY;
+        if (name == "champsim") return TraceFormat::CHAMPSIM;
+        throw std::invalid_argument("Unknown trace format: " + name);
+    }
+
+    struct DecompressingReader::Decoder {
+        enum class Codec { GZIP, XZ };
+
+        Codec codec;
+        const uint8_t* data;
+        size_t size;
+        size_t offset = 0;
+        bool done = false;
+        z_stream gzip{};
+        lzma_stream xz = LZMA_STREAM_INIT;
+
+        Decoder(Codec codec, const uint8_t* data, size_t size) : codec(codec), data(data), size(size) {
+            if (codec == Codec::GZIP) {
+                if (inflateInit2(&gzip, 15 + 16) != Z_OK) {
+                    throw std::runtime_error("Cannot initialize gzip decoder");
+                }
+            } else if (lzma_stream_decoder(&xz, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+                throw std::runtime_error("Cannot initialize xz decoder");
+            }
+        }
+
+        ~Decoder() {
+            if (codec == Codec::GZIP) {
+                inflateEnd(&gzip);
+            } else {
+                lzma_end(&xz);
+            }
+        }
+
+        size_t next_piece(const uint8_t*& piece) {
+            size_t count = std::min(size - offset, INPUT_PIECE);
+            piece = data + offset;
+            offset += count;
+            return count;
+        }
+
+        size_t read_gzip(uint8_t* buffer, size_t capacity) {
+            uInt wanted = static_cast<uInt>(std::min<size_t>(capacity, UINT_MAX));
+            gzip.next_out = buffer;
+            gzip.avail_out = wanted;
+            while (!done && gzip.avail_out == wanted) {
+                if (gzip.avail_in == 0) {
+                    if (offset == size) throw std::runtime_error("Truncated gzip stream");
+                    const uint8_t* piece;
+                    gzip.avail_in = static_cast<uInt>(next_piece(piece));
+                    gzip.next_in = const_cast<Bytef*>(piece);
+                }
+                int rc = inflate(&gzip, Z_NO_FLUSH);
+                if (rc == Z_STREAM_END) {
+                    if (gzip.avail_in == 0 && offset == size) {
+                        done = true;
+                    } else {
+                        inflateReset(&gzip); // следующий член gzip, как у gzip -d
+                    }
+                } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                    throw std::runtime_error("Corrupted gzip stream");
+                }
+            }
+            return wanted - gzip.avail_out;
+        }
+
+        size_t read_xz(uint8_t* buffer, size_t capacity) {
+            xz.next_out = buffer;
+            xz.avail_out = capacity;
+            while (!done && xz.avail_out == capacity) {
+                if (xz.avail_in == 0 && offset < size) {
+                    xz.avail_in = next_piece(xz.next_in);
+                }
+                lzma_ret rc = lzma_code(&xz, offset == size ? LZMA_FINISH : LZMA_RUN);
+                if (rc == LZMA_STREAM_END) {
+                    done = true;
+                } else if (rc != LZMA_OK) {
+                    throw std::runtime_error("Corrupted xz stream");
+                }
+            }
+            return capacity - xz.avail_out;
+        }
+    };
+
+    DecompressingReader::DecompressingReader(const std::string& path) : _file(path) {
+        if (starts_with(_file.data(), _file.size(), GZIP_MAGIC, sizeof(GZIP_MAGIC))) {
+            _decoder = std::make_unique<Decoder>(Decoder::Codec::GZIP, _file.data(), _file.size());
+        } else if (starts_with(_file.data(), _file.size(), XZ_MAGIC, sizeof(XZ_MAGIC))) {
+            _decoder = std::make_unique<Decoder>(Decoder::Codec::XZ, _file.data(), _file.size());
+        }
+    }
+
+    DecompressingReader::~DecompressingReader() = default;
+
+    size_t DecompressingReader::read(uint8_t* buffer, size_t capacity) {
+        if (!_decoder) {
+            size_t count = std::min(capacity, _file.size() - _offset);
+            if (count > 0) std::memcpy(buffer, _file.data() + _offset, count);
+            _offset += count;
+            return count;
+        }
+        return _decoder->codec == Decoder::Codec::GZIP ? _decoder->read_gzip(buffer, capacity)
+                                                      : _decoder->read_xz(buffer, capacity);
+    }
+
+    ImportedTraceReader::ImportedTraceReader(const std::string& path, TraceFormat format)
+        : _input(path), _format(format), _buffer(BUFFER_SIZE) {
+        if (format == TraceFormat::NATIVE) {
+            throw std::invalid_argument("Native traces are read by TextTraceReader and BinaryTraceReader");
+        }
+    }
+
+    // В буфере не меньше bytes непрочитанных байт; false - файл кончился раньше
+    bool ImportedTraceReader::fill(size_t bytes) {
+        while (_end - _begin < bytes && !_eof) {
+            if (_begin > 0) {
+                std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+                _end -= _begin;
+                _begin = 0;
+            }
+            if (_end == _buffer.size()) _buffer.resize(_buffer.size() * 2);
+            size_t count = _input.read(_buffer.data() + _end, _buffer.size() - _end);
+            _eof = count == 0;
+            _end += count;
+        }
+        return _end - _begin >= bytes;
+    }
+
+    // Строка действительна до следующего вызова
+    bool ImportedTraceReader::next_line(std::string_view& line) {
+        size_t scanned = 0;
+        for (;;) {
+            const char* start = reinterpret_cast<const char*>(_buffer.data() + _begin);
+            size_t available = _end - _begin;
+            const void* newline = std::memchr(start + scanned, '\n', available - scanned);
+            if (newline) {
+                size_t length = static_cast<const char*>(newline) - start;
+                line = std::string_view(start, length);
+                _begin += length + 1;
+                break;
+            }
+            scanned = available;
+            if (!fill(available + 1)) {
+                if (_end == _begin) return false;
+                line = std::string_view(reinterpret_cast<const char*>(_buffer.data() + _begin), _end - _begin);
+                _begin = _end;
+                break;
+            }
+        }
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        ++_position;
+        return true;
+    }
+
+    void ImportedTraceReader::push(TraceCommand command, uint64_t address, size_t size) {
+        TraceRecord& record = _pending[_pending_count++];
+        record.command = command;
+        record.query = InQuery{command == TraceCommand::STORE ? Operation::WRITE : Operation::READ, address, {}, size};
+        if (command == TraceCommand::STORE) {
+            record.query.data.valid_count = std::min((size + sizeof(int) - 1) / sizeof(int), Data::SIZE);
+        }
+    }
+
+    void ImportedTraceReader::fail(const std::string& message) const {
+        const char* unit = _format == TraceFormat::CHAMPSIM ? "record " : "line ";
+        throw std::runtime_error(unit + std::to_string(_position) + ": " + message);
+    }
+
+    void ImportedTraceReader::decode_dinero(std::string_view line) {
+        std::string_view rest = line;
+        std::string_view label = next_token(rest);
+        if (label.empty()) return;
+
+        uint64_t address;
+        if (label.size() != 1 || !parse_number(next_token(rest), address, 16)) {
+            fail("Invalid din record");
+        }
+        switch (label[0]) {
+            case '0': push(TraceCommand::LOAD, address, DINERO_ACCESS_SIZE); break;
+            case '1': push(TraceCommand::STORE, address, DINERO_ACCESS_SIZE); break;
+            case '2': // выборка команды
+            case '3': // escape
+            case '4': // сброс кэша
+                ++_skipped;
+                break;
+            default:
+                fail("Unknown din label: " + std::string(label));
+        }
+    }
+
+    void ImportedTraceReader::decode_lackey(std::string_view line) {
+        if (line.substr(0, 2) == "==") { // сообщения valgrind
+            ++_skipped;
+            return;
+        }
+        std::string_view rest = line;
+        std::string_view op = next_token(rest);
+        if (op.empty()) return;
+        if (op == "I") {
+            ++_skipped;
+            return;
+        }
+
+        uint64_t address;
+        size_t size;
+        if (op.size() != 1 || !parse_number(next_token(rest, ','), address, 16) ||
+            !parse_number(next_token(rest), size, 10)) {
+            fail("Invalid lackey record");
+        }
+        switch (op[0]) {
+            case 'L': push(TraceCommand::LOAD, address, size); break;
+            case 'S': push(TraceCommand::STORE, address, size); break;
+            case 'M': // чтение-модификация-запись
+                push(TraceCommand::LOAD, address, size);
+                push(TraceCommand::STORE, address, size);
+                break;
+            default:
+                fail("Unknown lackey operation: " + std::string(op));
+        }
+    }
+
+    // input_instr: ip, is_branch, branch_taken, destination_registers[2], source_registers[4],
+    // destination_memory[2] (смещение 16), source_memory[4] (смещение 32); нулевой адрес - нет обращения
+    void ImportedTraceReader::decode_champsim(const uint8_t* record) {
+        constexpr size_t DESTINATION_MEMORY = 16;
+        constexpr size_t SOURCE_MEMORY = 32;
+        for (size_t i = 0; i < 4; ++i) {
+            uint64_t address = load_le64(record + SOURCE_MEMORY + 8 * i);
+            if (address) push(TraceCommand::LOAD, address, CHAMPSIM_ACCESS_SIZE);
+        }
+        for (size_t i = 0; i < 2; ++i) {
+            uint64_t address = load_le64(record + DESTINATION_MEMORY + 8 * i);
+            if (address) push(TraceCommand::STORE, address, CHAMPSIM_ACCESS_SIZE);
+        }
+        if (_pending_count == 0) ++_skipped;
+    }
+
+    bool ImportedTraceReader::next(TraceRecord& record) {
+        while (_pending_next == _pending_count) {
+            _pending_next = _pending_count = 0;
+            if (_format == TraceFormat::CHAMPSIM) {
+                if (!fill(CHAMPSIM_RECORD_SIZE)) {
+                    if (_end != _begin) fail("Truncated ChampSim record");
+                    return false;
+                }
+                ++_position;
+                decode_champsim(_buffer.data() + _begin);
+                _begin += CHAMPSIM_RECORD_SIZE;
+            } else {
+                std::string_view line;
+                if (!next_line(line)) return false;
+                if (_format == TraceFormat::DINERO) {
+                    decode_dinero(line);
+                } else {
+                    decode_lackey(line);
+                }
+            }
+        }
+        record = _pending[_pending_next++];
+        return true;
+    }
+}
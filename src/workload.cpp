@@ -0,0 +1,267 @@
+#include "../include/workload.hpp"
+#include "../include/memory.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+
+namespace Cache {
+    namespace {
+        constexpr size_t BATCH = 256;
+
+        double parse_fraction(std::string_view key, std::string_view text) {
+            try {
+                size_t used = 0;
+                double value = std::stod(std::string(text), &used);
+                if (used == text.size()) return value;
+            } catch (const std::exception&) {
+            }
+            throw std::invalid_argument("Invalid value for " + std::string(key) + ": " + std::string(text));
+        }
+
+        WorkloadPattern parse_pattern(std::string_view name) {
+            if (name == "seq") return WorkloadPattern::SEQUENTIAL;
+            if (name == "stride") return WorkloadPattern::STRIDE;
+            if (name == "uniform") return WorkloadPattern::UNIFORM;
+            if (name == "zipf") return WorkloadPattern::ZIPF;
+            if (name == "chase") return WorkloadPattern::POINTER_CHASE;
+            if (name == "mixed") return WorkloadPattern::MIXED;
+            throw std::invalid_argument("Unknown workload pattern: " + std::string(name));
+        }
+
+        // log1p(x) / x и expm1(x) / x без потери точности около нуля
+        double helper1(double x) {
+            return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+        }
+
+        double helper2(double x) {
+            return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+        }
+
+        uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t m) {
+            return static_cast<uint64_t>(static_cast<unsigned __int128>(a) * b % m);
+        }
+    }
+
+    uint64_t parse_amount(std::string_view key, std::string_view text) {
+        const std::string_view original = text;
+        uint64_t multiplier = 1;
+        if (!text.empty()) {
+            switch (text.back()) {
+                case 'K': case 'k': multiplier = 1ULL << 10; break;
+                case 'M': case 'm': multiplier = 1ULL << 20; break;
+                case 'G': case 'g': multiplier = 1ULL << 30; break;
+                default: break;
+            }
+            if (multiplier != 1) text.remove_suffix(1);
+        }
+        uint64_t value = 0;
+        int base = 10;
+        if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+            text.remove_prefix(2);
+            base = 16;
+        }
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+        if (text.empty() || ec != std::errc() || ptr != text.data() + text.size()) {
+            throw std::invalid_argument("Invalid value for " + std::string(key) + ": " + std::string(text));
+        }
+        if (value > UINT64_MAX / multiplier) {
+            throw std::invalid_argument("Value for " + std::string(key) + " does not fit in 64 bits: " +
+                                        std::string(original));
+        }
+        return value * multiplier;
+    }
+
+    WorkloadSpec parse_workload_spec(const std::string& text) {
+        WorkloadSpec spec;
+        std::string_view rest = text;
+        size_t colon = rest.find(':');
+        spec.pattern = parse_pattern(rest.substr(0, colon));
+        if (spec.pattern == WorkloadPattern::MIXED) spec.read_ratio = 0.7;
+        rest.remove_prefix(colon == std::string_view::npos ? rest.size() : colon + 1);
+
+        while (!rest.empty()) {
+            colon = rest.find(':');
+            std::string_view item = rest.substr(0, colon);
+            rest.remove_prefix(colon == std::string_view::npos ? rest.size() : colon + 1);
+
+            size_t equals = item.find('=');
+            if (equals == std::string_view::npos) {
+                throw std::invalid_argument("Expected key=value in workload: " + std::string(item));
+            }
+            std::string_view key = item.substr(0, equals);
+            std::string_view value = item.substr(equals + 1);
+            if (key == "count") spec.count = parse_amount(key, value);
+            else if (key == "base") spec.base = parse_amount(key, value);
+            else if (key == "footprint") spec.footprint = parse_amount(key, value);
+            else if (key == "stride") spec.stride = parse_amount(key, value);
+            else if (key == "size") spec.size = parse_amount(key, value);
+            else if (key == "reads") spec.read_ratio = parse_fraction(key, value);
+            else if (key == "alpha") spec.alpha = parse_fraction(key, value);
+            else if (key == "seed") spec.seed = parse_amount(key, value);
+            else throw std::invalid_argument("Unknown workload parameter: " + std::string(key));
+        }
+
+        if (spec.size == 0 || spec.size > Data::SIZE * sizeof(int)) {
+            throw std::invalid_argument("Workload size must be 1.." + std::to_string(Data::SIZE * sizeof(int)));
+        }
+        if (spec.stride == 0 || spec.footprint < std::max<uint64_t>(spec.size, spec.stride)) {
+            throw std::invalid_argument("Workload footprint must hold at least one stride and one access");
+        }
+        if (spec.read_ratio < 0 || spec.read_ratio > 1 || spec.alpha < 0) {
+            throw std::invalid_argument("Workload reads must be in [0, 1] and alpha non-negative");
+        }
+        return spec;
+    }
+
+    // Таблица функции распределения заняла бы O(n) памяти и времени на построение,
+    // а n - число строк footprint: при footprint в десятки ГБ это сотни миллионов
+    ZipfSampler::ZipfSampler(uint64_t n, double exponent) : _n(n), _exponent(exponent) {
+        _h_integral_x1 = h_integral(1.5) - 1;
+        _h_integral_n = h_integral(static_cast<double>(n) + 0.5);
+        _s = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+    }
+
+    double ZipfSampler::h(double x) const {
+        return std::exp(-_exponent * std::log(x));
+    }
+
+    double ZipfSampler::h_integral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1 - _exponent) * log_x) * log_x;
+    }
+
+    double ZipfSampler::h_integral_inverse(double x) const {
+        double t = std::max(x * (1 - _exponent), -1.0);
+        return std::exp(helper1(t) * x);
+    }
+
+    uint64_t ZipfSampler::sample(XorShift& rng) const {
+        for (;;) {
+            double u01 = static_cast<double>(rng.next() >> 11) * 0x1.0p-53;
+            double u = _h_integral_n + u01 * (_h_integral_x1 - _h_integral_n);
+            double x = h_integral_inverse(u);
+            uint64_t k = static_cast<uint64_t>(std::clamp(x + 0.5, 1.0, static_cast<double>(_n)));
+            if (static_cast<double>(k) - x <= _s || u >= h_integral(static_cast<double>(k) + 0.5) - h(static_cast<double>(k))) {
+                return k;
+            }
+        }
+    }
+
+    // XorShift - тот же генератор, что у случайного вытеснения: одно 64-битное
+    // состояние, одинаковый поток при одинаковом seed и дешевле обращения к кэшу
+    WorkloadGenerator::WorkloadGenerator(const WorkloadSpec& spec)
+        : _spec(spec), _rng(spec.seed),
+          _words(spec.footprint / spec.size), _lines(spec.footprint / spec.stride) {
+        if (spec.pattern == WorkloadPattern::ZIPF || spec.pattern == WorkloadPattern::MIXED) {
+            _zipf = ZipfSampler(_lines, spec.alpha);
+            // Ранг умножается по модулю _lines на число, взаимно простое с _lines: это
+            // перестановка строк, и самые популярные не собираются в первых наборах
+            _scramble = 0x9E3779B97F4A7C15ULL % _lines;
+            while (_lines > 1 && (_scramble < 2 || std::gcd(_scramble, _lines) != 1)) ++_scramble;
+        }
+        if (spec.pattern == WorkloadPattern::POINTER_CHASE) {
+            if (_lines > UINT32_MAX) {
+                throw std::invalid_argument("Pointer chase footprint is limited to 2^32 strides");
+            }
+            // Алгоритм Саттоло: случайная перестановка из одного цикла. Обход проходит все
+            // строки, прежде чем повториться, и коротких петель, умещающихся в кэше, нет
+            _chain.resize(_lines);
+            std::iota(_chain.begin(), _chain.end(), 0);
+            for (uint64_t i = _lines - 1; i > 0; --i) {
+                std::swap(_chain[i], _chain[_rng.next() % i]);
+            }
+        }
+    }
+
+    double WorkloadGenerator::uniform() {
+        return static_cast<double>(_rng.next() >> 11) * 0x1.0p-53;
+    }
+
+    uint64_t WorkloadGenerator::zipf_line() {
+        return mul_mod(_zipf.sample(_rng) - 1, _scramble, _lines);
+    }
+
+    uint64_t WorkloadGenerator::next_sequential() {
+        uint64_t word = _sequential;
+        _sequential = _sequential + 1 == _words ? 0 : _sequential + 1;
+        return word * _spec.size;
+    }
+
+    uint64_t WorkloadGenerator::next_address() {
+        const WorkloadSpec& spec = _spec;
+        switch (spec.pattern) {
+            case WorkloadPattern::SEQUENTIAL:
+                return next_sequential();
+            case WorkloadPattern::STRIDE:
+            {
+                uint64_t line = _line;
+                _line = _line + 1 == _lines ? 0 : _line + 1;
+                return line * spec.stride;
+            }
+            case WorkloadPattern::UNIFORM:
+                return _rng.next() % _words * spec.size;
+            case WorkloadPattern::ZIPF:
+                return zipf_line() * spec.stride;
+            case WorkloadPattern::POINTER_CHASE:
+                _line = _chain[_line];
+                return _line * spec.stride;
+            case WorkloadPattern::MIXED:
+                switch (_rng.next() % 3) {
+                    case 0:
+                        return next_sequential();
+                    case 1:
+                        return _rng.next() % _words * spec.size;
+                    default:
+                        return zipf_line() * spec.stride;
+                }
+        }
+        return 0;
+    }
+
+    // Чтение или запись выбирается независимо от адреса. Записываются адреса слов,
+    // поэтому с --init 1 вывод легко проверить
+    void WorkloadGenerator::next(InQuery& query) {
+        query.address = _spec.base + next_address();
+        query.size = _spec.size;
+        if (_spec.read_ratio >= 1 || uniform() < _spec.read_ratio) {
+            query.operation = Operation::READ;
+            query.data.valid_count = 0;
+            return;
+        }
+        query.operation = Operation::WRITE;
+        size_t count = (_spec.size + sizeof(int) - 1) / sizeof(int);
+        for (size_t i = 0; i < count; ++i) {
+            query.data.buffer[i] = static_cast<int>(query.address + i * sizeof(int));
+        }
+        query.data.valid_count = count;
+    }
+
+    // Пакеты по BATCH через query_batch, как в run_tests: --gen меряет тот же путь,
+    // что и прогон трассы, только без чтения и разбора файла
+    void run_workload(const WorkloadSpec& spec, MemoryHierarchy& hierarchy) {
+        WorkloadGenerator generator(spec);
+        std::vector<InQuery> queries(BATCH);
+        std::vector<OutQuery> results(BATCH);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t done = 0; done < spec.count;) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(BATCH, spec.count - done));
+            for (size_t i = 0; i < count; ++i) generator.next(queries[i]);
+            hierarchy.query_batch(queries.data(), count, results.data());
+            done += count;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double seconds = elapsed.count();
+        hierarchy.report().flush();
+        std::cout << "Generated " << spec.count << " accesses in " << std::fixed << std::setprecision(3)
+                  << seconds * 1e3 << " ms: " << std::setprecision(2)
+                  << (seconds > 0 ? spec.count / seconds / 1e6 : 0.0) << " M accesses/s, "
+                  << (spec.count ? seconds * 1e9 / spec.count : 0.0) << " ns/access"
+                  << std::defaultfloat << std::endl;
+    }
+}
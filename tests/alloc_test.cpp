@@ -0,0 +1,82 @@
+#include "memory.hpp"
+#include "static_cache.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace Cache;
+
+// Проверка: установившееся обращение к иерархии не выделяет память в куче
+namespace {
+    std::atomic<size_t> allocations{0};
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+    constexpr uint64_t RANGE = 0x10000; // больше любого из кэшей
+
+    std::vector<InQuery> make_accesses() {
+        std::vector<InQuery> accesses;
+        uint64_t seed = 12345;
+        for (size_t i = 0; i < 20000; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint64_t address = (seed >> 33) % RANGE & ~uint64_t{63};
+            Data data;
+            data[0] = static_cast<int>(i);
+            data.valid_count = 1;
+            bool write = (seed >> 20) % 4 == 0;
+            accesses.push_back(InQuery{write ? Operation::WRITE : Operation::READ, address, data, 4});
+        }
+        return accesses;
+    }
+
+    bool check(const char* name, std::shared_ptr<MemoryModel> memory, std::shared_ptr<MemoryHierarchy> hierarchy,
+               const std::vector<InQuery>& accesses) {
+        // Заранее записываем весь диапазон, чтобы таблицы памяти больше не росли
+        for (uint64_t address = 0; address < RANGE; address += 64) {
+            memory->query(InQuery{Operation::WRITE, address, Data{}, 4});
+        }
+        // Прогревочный проход заполняет кэши, второй - установившийся режим
+        for (const auto& access : accesses) hierarchy->query(access);
+
+        size_t before = allocations.load();
+        for (const auto& access : accesses) hierarchy->query(access);
+        size_t count = allocations.load() - before;
+
+        std::cout << name << ": " << count << " allocations in " << accesses.size() << " accesses\n";
+        return count == 0;
+    }
+}
+
+int main() {
+    auto accesses = make_accesses();
+    bool ok = true;
+
+    {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ZEROS);
+        ok &= check("model1", memory, make_model1_hierarchy(memory), accesses);
+    }
+    {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ZEROS);
+        ok &= check("model2", memory, make_model2_hierarchy(memory), accesses);
+    }
+    {
+        auto memory = std::make_shared<MemoryModel>();
+        std::vector<std::shared_ptr<Cache::Cache>> caches{
+            make_cache(8 * 1024, 64, 8, 32, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::SRRIP)};
+        ok &= check("tags-only", memory, std::make_shared<MemoryHierarchy>(caches, memory, TraceLevel::NONE, DataMode::TAGS_ONLY), accesses);
+    }
+
+    return ok ? 0 : 1;
+}
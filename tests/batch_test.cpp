@@ -0,0 +1,129 @@
+#include "memory.hpp"
+
+#include <fstream>
+
+using namespace Cache;
+
+// Проверка: query_batch даёт те же ответы и то же итоговое состояние,
+// что и последовательные вызовы query
+namespace {
+    using HierarchyFactory = std::shared_ptr<MemoryHierarchy> (*)();
+
+    std::shared_ptr<MemoryHierarchy> make_model1() {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return make_model1_hierarchy(memory);
+    }
+
+    std::shared_ptr<MemoryHierarchy> make_model2() {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return make_model2_hierarchy(memory);
+    }
+
+    std::vector<InQuery> load_trace(const std::string& path) {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            throw std::runtime_error("Cannot open trace: " + path);
+        }
+
+        std::vector<InQuery> queries;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream iss(line);
+            std::string op;
+            size_t size;
+            uint64_t address;
+            if (!(iss >> op >> size >> std::hex >> address)) continue; // пустые строки и show
+
+            Data data;
+            std::string value;
+            while (op == "st" && iss >> value && data.valid_count < Data::SIZE) {
+                data[data.valid_count++] = static_cast<int>(std::stoul(value, nullptr, 16));
+            }
+            queries.push_back(InQuery{op == "ld" ? Operation::READ : Operation::WRITE, address, data, size});
+        }
+        return queries;
+    }
+
+    // Длинная случайная последовательность, чтобы предвыборка работала на всю дистанцию
+    std::vector<InQuery> make_random(size_t count) {
+        std::vector<InQuery> queries;
+        uint64_t seed = 777;
+        for (size_t i = 0; i < count; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            Data data;
+            data[0] = static_cast<int>(i);
+            data.valid_count = 1;
+            bool write = (seed >> 20) % 3 == 0;
+            queries.push_back(InQuery{write ? Operation::WRITE : Operation::READ,
+                                      (seed >> 33) % 0x8000 & ~uint64_t{63}, data, 4});
+        }
+        return queries;
+    }
+
+    bool same_result(const OutQuery& a, const OutQuery& b) {
+        if (a.hit != b.hit || a.evicted != b.evicted || a.evicted_tag != b.evicted_tag) return false;
+        if (a.returned_data.has_value() != b.returned_data.has_value()) return false;
+        if (!a.returned_data) return true;
+        if (a.returned_data->valid_count != b.returned_data->valid_count) return false;
+        for (size_t i = 0; i < a.returned_data->valid_count; ++i) {
+            if ((*a.returned_data)[i] != (*b.returned_data)[i]) return false;
+        }
+        return true;
+    }
+
+    std::string final_state(MemoryHierarchy& hierarchy) {
+        std::ostringstream state;
+        auto* old = std::cout.rdbuf(state.rdbuf());
+        hierarchy.print_caches_state();
+        std::cout.rdbuf(old);
+        return state.str();
+    }
+
+    bool check(const std::string& name, HierarchyFactory factory, const std::vector<InQuery>& queries) {
+        auto reference = factory();
+        std::vector<OutQuery> expected;
+        for (const auto& query : queries) expected.push_back(reference->query(query));
+        std::string expected_state = final_state(*reference);
+
+        bool ok = true;
+        for (size_t batch : {1, 16, 256, 4096}) {
+            auto hierarchy = factory();
+            std::vector<OutQuery> results(queries.size());
+            for (size_t first = 0; first < queries.size(); first += batch) {
+                size_t count = std::min(batch, queries.size() - first);
+                hierarchy->query_batch(queries.data() + first, count, results.data() + first);
+            }
+
+            for (size_t i = 0; i < queries.size(); ++i) {
+                if (!same_result(expected[i], results[i])) {
+                    std::cout << name << " batch=" << batch << ": result mismatch at access " << i << "\n";
+                    ok = false;
+                    break;
+                }
+            }
+            if (final_state(*hierarchy) != expected_state) {
+                std::cout << name << " batch=" << batch << ": final state mismatch\n";
+                ok = false;
+            }
+        }
+        std::cout << name << ": " << queries.size() << " accesses " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::pair<std::string, std::vector<InQuery>>> traces;
+    for (int i = 1; i < argc; ++i) {
+        traces.emplace_back(argv[i], load_trace(argv[i]));
+    }
+    traces.emplace_back("random", make_random(20000));
+
+    bool ok = true;
+    for (const auto& [name, queries] : traces) {
+        ok &= check("model1 " + name, make_model1, queries);
+        ok &= check("model2 " + name, make_model2, queries);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+# Вывод --test с --pipeline должен побайтно совпадать с последовательным,
+# отдельно stdout и stderr (сообщения об ошибочных строках):
+#   cmake -DPROGRAM=<model1|model2> -DTRACE=<трасса> -P compare_pipeline.cmake
+set(ARGS --test ${TRACE} --trace 3 --init 1)
+execute_process(COMMAND ${PROGRAM} ${ARGS}
+                OUTPUT_VARIABLE serial_out ERROR_VARIABLE serial_err RESULT_VARIABLE serial_result)
+execute_process(COMMAND ${PROGRAM} ${ARGS} --pipeline
+                OUTPUT_VARIABLE pipelined_out ERROR_VARIABLE pipelined_err RESULT_VARIABLE pipelined_result)
+
+if(NOT serial_result EQUAL 0 OR NOT pipelined_result EQUAL 0)
+    message(FATAL_ERROR "exit codes: serial ${serial_result}, pipelined ${pipelined_result}")
+endif()
+if(serial_out STREQUAL "")
+    message(FATAL_ERROR "serial run printed nothing")
+endif()
+if(NOT serial_out STREQUAL pipelined_out)
+    message(FATAL_ERROR "stdout differs between serial and --pipeline runs of ${TRACE}")
+endif()
+if(NOT serial_err STREQUAL pipelined_err)
+    message(FATAL_ERROR "stderr differs between serial and --pipeline runs of ${TRACE}:\n"
+                        "serial:\n${serial_err}\npipelined:\n${pipelined_err}")
+endif()
@@ -0,0 +1,166 @@
+#include "event_trace.hpp"
+#include "memory.hpp"
+#include "report.hpp"
+#include "workload.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+using namespace Cache;
+
+// Проверка двоичной трассы событий: расшифровка совпадает с текстовой трассой
+// --trace 2 без данных блоков, а события нескольких потоков не теряются и
+// идут внутри потока по порядку запросов
+namespace {
+    std::shared_ptr<MemoryHierarchy> make_model2(std::shared_ptr<MemoryModel> memory, TraceLevel trace) {
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return make_model2_hierarchy(memory, trace);
+    }
+
+    // Строки обращений из вывода --trace 2 без data=[...] и без строк с записанными данными
+    std::string access_lines(const std::string& text) {
+        std::istringstream in(text);
+        std::string result;
+        for (std::string line; std::getline(in, line);) {
+            bool cache_line = line.size() > 2 && line[0] == 'L' && std::isdigit(static_cast<unsigned char>(line[1]));
+            bool memory_line = line.rfind("MEM: ", 0) == 0 && line.rfind("MEM: WRITE data=", 0) != 0;
+            if (!cache_line && !memory_line) continue;
+            size_t data = line.find(" data=[");
+            if (data != std::string::npos) line.erase(data, line.find(']', data) + 1 - data);
+            result += line + "\n";
+        }
+        return result;
+    }
+
+    std::string decode(const std::string& path, TraceLevel level) {
+        std::ostringstream out;
+        ReportSink report(out);
+        EventLogReader reader(path);
+        uint32_t thread;
+        TraceEvent event;
+        while (reader.next(thread, event)) report_event(report, event, level);
+        report.flush();
+        return out.str();
+    }
+
+    bool check_decode(const std::string& trace, const std::string& log_path) {
+        std::ostringstream text;
+        auto memory = std::make_shared<MemoryModel>(TraceLevel::FULL);
+        memory->set_report(std::make_shared<ReportSink>(text));
+        memory->set_event_log(std::make_shared<EventLog>(log_path));
+        auto hierarchy = make_model2(memory, TraceLevel::FULL);
+
+        MappedFile file(trace);
+        TextTraceReader reader(file.data(), file.size());
+        TraceRecord record;
+        std::string_view line;
+        std::string error;
+        while (reader.next_line(line)) {
+            if (parse_trace_line(line, record, error)) {
+                run_text_record(*hierarchy, record.command, record.query, line);
+            }
+        }
+        hierarchy->report().flush();
+        memory->set_event_log(nullptr); // журнал закрывается
+
+        std::string expected = access_lines(text.str());
+        bool ok = !expected.empty() && decode(log_path, TraceLevel::FULL) == expected;
+        std::remove(log_path.c_str());
+        std::cout << trace << ": decoded events " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Обращения потока t: нагрузки разной длины, чтобы потоки различались. Текстовая
+    // трасса выключена - общий вывод std::cout не рассчитан на несколько потоков
+    void run_workload_thread(size_t t, std::shared_ptr<EventLog> log) {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->set_event_log(std::move(log));
+        auto hierarchy = make_model2(memory, TraceLevel::NONE);
+        WorkloadSpec spec = parse_workload_spec("zipf:count=" + std::to_string(5000 * (t + 1)) +
+                                                ":footprint=256K:reads=0.7:seed=" + std::to_string(t + 1));
+        WorkloadGenerator generator(spec);
+        InQuery query;
+        for (uint64_t i = 0; i < spec.count; ++i) {
+            generator.next(query);
+            hierarchy->query(query);
+        }
+    }
+
+    // Теги за пределами 32 бит (48-битные адреса) сохраняются без усечения
+    bool check_wide_tag(const std::string& log_path) {
+        constexpr uint64_t TAG = 0x4'0000'0001ULL;
+        {
+            EventLog log(log_path);
+            log.next_request();
+            log.record(0, Operation::READ, 0x500000000000ULL, 4, false, true, TAG);
+        }
+        EventLogReader reader(log_path);
+        uint32_t thread;
+        TraceEvent event;
+        bool ok = reader.next(thread, event) && event.evicted_tag == TAG && (event.flags & TraceEvent::EVICTED) &&
+                  event.address == 0x500000000000ULL && !reader.next(thread, event);
+        std::remove(log_path.c_str());
+        std::cout << "wide tag: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    using EventStream = std::vector<TraceEvent>;
+
+    std::vector<EventStream> read_streams(const std::string& path) {
+        std::vector<EventStream> streams;
+        EventLogReader reader(path);
+        uint32_t thread;
+        TraceEvent event;
+        while (reader.next(thread, event)) {
+            if (thread >= streams.size()) streams.resize(thread + 1);
+            streams[thread].push_back(event);
+        }
+        std::remove(path.c_str());
+        return streams;
+    }
+
+    bool same(const EventStream& a, const EventStream& b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(TraceEvent)) == 0;
+    }
+
+    // Каждый поток записывает то же, что и одиночный прогон его нагрузки
+    bool check_threads(const std::string& log_path) {
+        constexpr size_t THREADS = 4;
+        std::vector<EventStream> expected;
+        for (size_t t = 0; t < THREADS; ++t) {
+            run_workload_thread(t, std::make_shared<EventLog>(log_path));
+            auto streams = read_streams(log_path);
+            if (streams.size() != 1) return false;
+            expected.push_back(std::move(streams[0]));
+        }
+
+        auto log = std::make_shared<EventLog>(log_path);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) threads.emplace_back(run_workload_thread, t, log);
+        for (auto& thread : threads) thread.join();
+        log->close();
+
+        // Номера потоков в журнале - в порядке первой записи, потоки сопоставляются по длине
+        auto actual = read_streams(log_path);
+        auto by_size = [](const EventStream& a, const EventStream& b) { return a.size() < b.size(); };
+        std::sort(actual.begin(), actual.end(), by_size);
+        bool ok = actual.size() == THREADS;
+        for (size_t t = 0; ok && t < THREADS; ++t) ok = same(actual[t], expected[t]);
+        std::cout << "threads: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool ok = true;
+    for (int i = 1; i < argc; ++i) {
+        ok &= check_decode(argv[i], "event_trace_test.bin");
+    }
+    ok &= check_wide_tag("event_trace_test_tag.bin");
+    ok &= check_threads("event_trace_test_threads.bin");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+# Неверный аргумент - сообщение "Error: ..." в stderr и код выхода 1, а не
+# аварийное завершение:
+#   cmake -DPROGRAM=<программа> "-DARGS=<аргументы через пробел>" -P expect_error.cmake
+separate_arguments(args UNIX_COMMAND "${ARGS}")
+execute_process(COMMAND ${PROGRAM} ${args}
+                OUTPUT_VARIABLE out ERROR_VARIABLE err RESULT_VARIABLE result)
+
+if(NOT result STREQUAL "1")
+    message(FATAL_ERROR "expected exit code 1, got ${result}:\n${err}")
+endif()
+if(NOT err MATCHES "^Error: ")
+    message(FATAL_ERROR "expected an Error: message, got:\n${err}")
+endif()
@@ -0,0 +1,130 @@
+#include "memory.hpp"
+
+#include <fstream>
+#include <unordered_map>
+
+using namespace Cache;
+
+// Проверка иерархии: загрузки model1 и model2 возвращают то же, что плоская
+// память, в которую по очереди выполнены все записи; test3.txt при памяти с
+// адресами слов даёт заранее известные значения; счётчики уровней model2
+// учитывают каждый настоящий запрос к уровню ровно один раз
+namespace {
+    using HierarchyFactory = std::shared_ptr<MemoryHierarchy> (*)(std::shared_ptr<MemoryModel>, TraceLevel,
+                                                                  DataMode, InsertionPolicy);
+
+    std::shared_ptr<MemoryHierarchy> make(HierarchyFactory factory) {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return factory(memory, TraceLevel::NONE, DataMode::FULL, InsertionPolicy::NORMAL);
+    }
+
+    std::vector<int> loaded(const OutQuery& result) {
+        if (!result.returned_data) return {};
+        const Data& data = *result.returned_data;
+        return std::vector<int>(data.buffer.begin(), data.buffer.begin() + data.valid_count);
+    }
+
+    bool check_test3(const std::string& name, HierarchyFactory factory, const std::string& path) {
+        const std::vector<std::vector<int>> expected{
+            {52}, {56, 60}, {0x1234}, {0x5555}, {112}, {0x103c}, {0x203c}, {0x303c}, {0x403c}, {0x1234}};
+
+        std::ifstream in(path);
+        auto hierarchy = make(factory);
+        std::vector<std::vector<int>> actual;
+        TraceRecord record;
+        std::string line, error;
+        while (std::getline(in, line)) {
+            if (!parse_trace_line(line, record, error) || record.command == TraceCommand::SHOW) continue;
+            OutQuery result = hierarchy->query(record.query);
+            if (record.command == TraceCommand::LOAD) actual.push_back(loaded(result));
+        }
+        bool ok = actual == expected;
+        std::cout << name << " test3 loads: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Обращения по 4 байта в пределах 64 КБ: вытеснения в L1 model2 и в обоих
+    // уровнях, записи вперемешку с чтениями
+    bool check_reference(const std::string& name, HierarchyFactory factory) {
+        auto hierarchy = make(factory);
+        std::unordered_map<uint64_t, int> written;
+        uint64_t seed = 11;
+        size_t mismatches = 0;
+        for (int i = 0; i < 50000; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint64_t address = (seed >> 24) & 0xfffc;
+            if ((seed >> 61) < 3) {
+                Data value;
+                value[0] = static_cast<int>(seed >> 33);
+                value.valid_count = 1;
+                hierarchy->query(InQuery{Operation::WRITE, address, value, 4});
+                written[address] = value[0];
+            } else {
+                auto it = written.find(address);
+                int expected = it != written.end() ? it->second : static_cast<int>(address);
+                std::vector<int> values = loaded(hierarchy->query(InQuery{Operation::READ, address, Data{}, 4}));
+                mismatches += values.size() != 1 || values[0] != expected;
+            }
+        }
+        std::cout << name << " loads vs flat memory: " << (mismatches == 0 ? "OK" : "FAILED") << "\n";
+        return mismatches == 0;
+    }
+
+    struct LevelCounts {
+        uint64_t reads, read_hits, writes, write_hits, fills, evictions, dirty_writebacks, write_throughs, bypasses;
+    };
+
+    bool same_counts(const CacheStats& stats, const LevelCounts& expected) {
+        return stats.reads == expected.reads && stats.read_hits == expected.read_hits &&
+               stats.writes == expected.writes && stats.write_hits == expected.write_hits &&
+               stats.fills == expected.fills && stats.evictions == expected.evictions &&
+               stats.dirty_writebacks == expected.dirty_writebacks &&
+               stats.write_throughs == expected.write_throughs && stats.bypasses == expected.bypasses;
+    }
+
+    // Все адреса попадают в набор 0 L1 (шаг 4 KB), пятый блок вытесняет грязный.
+    // L1 (MRU, BOTH, write-back) подкачивает блок и при промахе записи; L2 заводит
+    // блок только на запись и пропускает чтения в память
+    bool check_counts(DataMode data_mode) {
+        const char* const TRACE[] = {
+            "ld 4 0x0",      // L1 промах, L2 пропуск, память: чтение
+            "st 4 0x4 1",    // L1 попадание, блок грязный
+            "st 4 0x1000 2", // L1 промах записи: подкачка через L2 из памяти
+            "ld 4 0x2000",   // L1 промах, L2 пропуск, память: чтение
+            "ld 4 0x3000",   // то же, набор L1 заполнен
+            "st 4 0x0 3",    // L1 попадание, 0x0 - последний использованный
+            "ld 4 0x4000",   // MRU вытесняет грязный 0x0: L2 заводит его и пишет в память, затем чтение 0x4000
+            "ld 4 0x0",      // вытесняется 0x4000, блок 0x0 читается из L2
+        };
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        auto hierarchy = make_model2_hierarchy(memory, TraceLevel::NONE, data_mode);
+        TraceRecord record;
+        std::string error;
+        for (std::string_view line : TRACE) {
+            parse_trace_line(line, record, error);
+            hierarchy->query(record.query);
+        }
+
+        bool ok = same_counts(hierarchy->get_level_stats(0), {5, 0, 3, 2, 6, 2, 1, 0, 0});
+        ok &= same_counts(hierarchy->get_level_stats(1), {6, 1, 1, 0, 1, 0, 0, 1, 5});
+        ok &= hierarchy->get_memory_stats().reads == 5 && hierarchy->get_memory_stats().writes == 1;
+        std::cout << "model2 level counts" << (data_mode == DataMode::TAGS_ONLY ? " (tags only)" : "") << ": "
+                  << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool ok = true;
+    if (argc > 1) {
+        ok &= check_test3("model1", make_model1_hierarchy, argv[1]);
+        ok &= check_test3("model2", make_model2_hierarchy, argv[1]);
+    }
+    ok &= check_reference("model1", make_model1_hierarchy);
+    ok &= check_reference("model2", make_model2_hierarchy);
+    ok &= check_counts(DataMode::FULL);
+    ok &= check_counts(DataMode::TAGS_ONLY);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include "memory.hpp"
+#include "trace_import.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <lzma.h>
+#include <zlib.h>
+
+using namespace Cache;
+
+// Проверка импорта: одна и та же последовательность обращений, записанная в
+// форматах din, lackey и ChampSim (в том числе сжатых), читается обратно без
+// изменений, а прогон через run_tests даёт то же состояние, что и прямые запросы
+namespace {
+    struct Access {
+        TraceCommand command;
+        uint64_t address;
+        size_t size;
+    };
+
+    std::shared_ptr<MemoryHierarchy> make_model2() {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return make_model2_hierarchy(memory);
+    }
+
+    // Обращения в пределах 1 МБ, чтобы попадания и вытеснения перемешивались
+    std::vector<Access> make_accesses(size_t count, size_t size) {
+        std::vector<Access> accesses;
+        uint64_t seed = 7;
+        for (size_t i = 0; i < count; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            TraceCommand command = (seed >> 61) < 5 ? TraceCommand::LOAD : TraceCommand::STORE;
+            accesses.push_back({command, ((seed >> 20) & 0xFFFFF) & ~uint64_t{size - 1}, size});
+        }
+        return accesses;
+    }
+
+    std::string to_dinero(const std::vector<Access>& accesses) {
+        std::ostringstream out;
+        out << std::hex;
+        for (size_t i = 0; i < accesses.size(); ++i) {
+            if (i % 5 == 0) out << "2 " << 0x400000 + i * 4 << "\n"; // выборки команд пропускаются
+            out << (accesses[i].command == TraceCommand::LOAD ? 0 : 1) << " " << accesses[i].address << "\n";
+        }
+        return out.str();
+    }
+
+    std::string to_lackey(const std::vector<Access>& accesses) {
+        std::ostringstream out;
+        out << "==123== Lackey, an example Valgrind tool\n" << std::hex;
+        for (size_t i = 0; i < accesses.size(); ++i) {
+            if (i % 5 == 0) out << "I  " << 0x400000 + i * 4 << ",3\n";
+            char op = accesses[i].command == TraceCommand::LOAD ? 'L' : 'S';
+            out << " " << op << " " << std::setw(8) << std::setfill('0') << accesses[i].address
+                << "," << std::dec << accesses[i].size << std::hex << "\n";
+        }
+        out << "==123== \n";
+        return out.str();
+    }
+
+    // По инструкции на обращение: чтения в source_memory[0], записи в destination_memory[0]
+    std::string to_champsim(const std::vector<Access>& accesses) {
+        std::string out;
+        for (size_t i = 0; i < accesses.size(); ++i) {
+            uint8_t record[CHAMPSIM_RECORD_SIZE] = {};
+            uint64_t ip = 0x400000 + i * 4;
+            size_t field = accesses[i].command == TraceCommand::LOAD ? 32 : 16;
+            for (size_t b = 0; b < 8; ++b) {
+                record[b] = static_cast<uint8_t>(ip >> (8 * b));
+                record[field + b] = static_cast<uint8_t>(accesses[i].address >> (8 * b));
+            }
+            out.append(reinterpret_cast<const char*>(record), sizeof(record));
+            if (i % 5 == 0) out.append(sizeof(record), '\0'); // инструкция без обращений к памяти
+        }
+        return out;
+    }
+
+    std::string gzip(const std::string& bytes) {
+        uLongf size = compressBound(bytes.size()) + 32;
+        std::string out(size, '\0');
+        z_stream stream{};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(bytes.data()));
+        stream.avail_in = static_cast<uInt>(bytes.size());
+        stream.next_out = reinterpret_cast<Bytef*>(out.data());
+        stream.avail_out = static_cast<uInt>(out.size());
+        deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        return out;
+    }
+
+    std::string xz(const std::string& bytes) {
+        std::string out(lzma_stream_buffer_bound(bytes.size()), '\0');
+        size_t size = 0;
+        lzma_easy_buffer_encode(6, LZMA_CHECK_CRC64, nullptr, reinterpret_cast<const uint8_t*>(bytes.data()),
+                                bytes.size(), reinterpret_cast<uint8_t*>(out.data()), &size, out.size());
+        out.resize(size);
+        return out;
+    }
+
+    void write_file(const std::string& path, const std::string& bytes) {
+        std::ofstream out(path, std::ios::binary);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    std::string captured(const std::function<void()>& action) {
+        std::ostringstream text;
+        auto* old = std::cout.rdbuf(text.rdbuf());
+        action();
+        std::cout.rdbuf(old);
+        return text.str();
+    }
+
+    bool check_read(const std::string& name, const std::string& path, TraceFormat format,
+                    const std::vector<Access>& accesses) {
+        ImportedTraceReader reader(path, format);
+        TraceRecord record;
+        size_t i = 0;
+        for (; reader.next(record); ++i) {
+            const InQuery& query = record.query;
+            bool store = record.command == TraceCommand::STORE;
+            if (i >= accesses.size() || record.command != accesses[i].command ||
+                query.address != accesses[i].address || query.size != accesses[i].size ||
+                query.operation != (store ? Operation::WRITE : Operation::READ) ||
+                query.data.valid_count != (store ? (query.size + 3) / 4 : 0)) {
+                std::cout << name << ": record " << i << " differs\n";
+                return false;
+            }
+        }
+        if (i != accesses.size()) {
+            std::cout << name << ": read " << i << " of " << accesses.size() << " records\n";
+            return false;
+        }
+        std::cout << name << ": " << i << " records, " << reader.skipped() << " skipped OK\n";
+        return true;
+    }
+
+    bool check_run(const std::string& name, const std::string& path, TraceFormat format,
+                   const std::vector<Access>& accesses) {
+        auto direct = make_model2();
+        auto imported = make_model2();
+        std::string expected = captured([&] {
+            for (const auto& access : accesses) {
+                InQuery query{access.command == TraceCommand::LOAD ? Operation::READ : Operation::WRITE,
+                              access.address, {}, access.size};
+                if (access.command == TraceCommand::STORE) query.data.valid_count = (access.size + 3) / 4;
+                direct->query(query);
+            }
+            direct->print_caches_state();
+            direct->print_stats(true);
+        });
+        captured([&] { run_tests(path, imported, TraceIngestion::SERIAL, format); });
+        std::string actual = captured([&] {
+            imported->print_caches_state();
+            imported->print_stats(true);
+        });
+
+        bool ok = actual == expected;
+        std::cout << name << ": run " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check(const std::string& name, const std::string& bytes, TraceFormat format,
+               const std::vector<Access>& accesses) {
+        std::string path = "import_test_" + name; // в рабочем каталоге теста
+        write_file(path, bytes);
+        bool ok = check_read(name, path, format, accesses) && check_run(name, path, format, accesses);
+        std::remove(path.c_str());
+        return ok;
+    }
+
+    bool check_malformed() {
+        write_file("import_test_bad.din", "0 100\n7 200\n");
+        bool ok = false;
+        try {
+            ImportedTraceReader reader("import_test_bad.din", TraceFormat::DINERO);
+            TraceRecord record;
+            while (reader.next(record)) {}
+        } catch (const std::runtime_error& e) {
+            ok = std::string(e.what()).rfind("line 2:", 0) == 0;
+        }
+        std::remove("import_test_bad.din");
+        std::cout << "malformed din: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main() {
+    bool ok = true;
+    auto words = make_accesses(20000, DINERO_ACCESS_SIZE);
+    auto qwords = make_accesses(20000, CHAMPSIM_ACCESS_SIZE);
+    ok &= check("din", to_dinero(words), TraceFormat::DINERO, words);
+    ok &= check("din.gz", gzip(to_dinero(words)), TraceFormat::DINERO, words);
+    ok &= check("lackey", to_lackey(qwords), TraceFormat::LACKEY, qwords);
+    ok &= check("lackey.xz", xz(to_lackey(qwords)), TraceFormat::LACKEY, qwords);
+    ok &= check("champsim.xz", xz(to_champsim(qwords)), TraceFormat::CHAMPSIM, qwords);
+    ok &= check("champsim.gz", gzip(to_champsim(qwords)), TraceFormat::CHAMPSIM, qwords);
+    ok &= check_malformed();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "cache.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace Cache;
+
+// Проверка адаптивной вставки: лидеров каждой политики поровну и ведомых не меньше
+// половины наборов, слишком маленький кэш ADAPTIVE не принимает; PSEL уходит к
+// BIMODAL на потоке, который не помещается в кэш, и к NORMAL на рабочем множестве,
+// которое помещается
+namespace {
+    constexpr uint64_t BLOCK = 64;
+    constexpr size_t WAYS = 8;
+    constexpr size_t SETS = 128;
+    constexpr uint64_t CAPACITY_BLOCKS = SETS * WAYS;
+
+    bool check_roles() {
+        bool ok = true;
+        for (size_t sets : {16, 32, 64, 128, 1024, 4096}) {
+            InsertionController controller(InsertionPolicy::ADAPTIVE, sets);
+            size_t normal = controller.leader_sets(false);
+            size_t bimodal = controller.leader_sets(true);
+            bool good = normal > 0 && normal == bimodal && sets - normal - bimodal >= sets / 2;
+            if (!good) {
+                std::cout << sets << " sets: " << normal << " normal and " << bimodal << " bimodal leaders\n";
+            }
+            ok &= good;
+        }
+        for (size_t sets : {1, 2, 4, 8}) {
+            bool rejected = false;
+            try {
+                InsertionController controller(InsertionPolicy::ADAPTIVE, sets);
+            } catch (const std::invalid_argument&) {
+                rejected = true;
+            }
+            InsertionController bimodal(InsertionPolicy::BIMODAL, sets); // бимодальной вставке лидеры не нужны
+            if (!rejected) std::cout << sets << " sets: adaptive accepted\n";
+            ok &= rejected;
+        }
+        std::cout << "leader roles: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    std::unique_ptr<Cache::Cache> make_adaptive() {
+        auto cache = std::make_unique<Cache::Cache>(SETS * WAYS * BLOCK, BLOCK, WAYS, 48, WritePolicy::WRITE_BACK,
+                                                    AllocationPolicy::BOTH, ReplacementPolicy::LRU);
+        cache->set_data_mode(DataMode::TAGS_ONLY);
+        cache->set_insertion_policy(InsertionPolicy::ADAPTIVE);
+        return cache;
+    }
+
+    void read(Cache::Cache& cache, uint64_t block) {
+        cache.query(InQuery{Operation::READ, block * BLOCK, Data{}, 4});
+    }
+
+    // Циклический обход 1.5 ёмкости: LRU промахивается всегда, бимодальные лидеры удерживают часть блоков
+    bool check_streaming() {
+        auto cache = make_adaptive();
+        const uint64_t accesses = 200000;
+        for (uint64_t i = 0; i < accesses; ++i) read(*cache, i % (CAPACITY_BLOCKS * 3 / 2));
+
+        const InsertionController& controller = *cache->get_insertion_controller();
+        bool ok = controller.psel() > InsertionController::PSEL_MAX * 3 / 4;
+        ok &= controller.follower_sets(true) > controller.follower_sets(false);
+        ok &= controller.psel_history().size() == accesses / InsertionController::SAMPLE_PERIOD;
+        std::cout << "streaming: PSEL=" << controller.psel() << " " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Окно в половину ёмкости медленно сдвигается, и каждый новый блок ещё много раз
+    // читается. Бимодальный лидер вставляет новый блок в дальнюю позицию, и следующий
+    // промах набора вытесняет его до повторных чтений, поэтому промахов у него больше
+    bool check_fitting() {
+        auto cache = make_adaptive();
+        const uint64_t window = CAPACITY_BLOCKS / 2;
+        XorShift rng(5);
+        for (uint64_t i = 0; i < 400000; ++i) read(*cache, i / 8 + rng.next() % window);
+
+        const InsertionController& controller = *cache->get_insertion_controller();
+        bool ok = controller.psel() < InsertionController::PSEL_MAX / 4;
+        ok &= controller.follower_sets(false) > controller.follower_sets(true);
+        std::cout << "fitting: PSEL=" << controller.psel() << " " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main() {
+    bool ok = check_roles();
+    ok &= check_streaming();
+    ok &= check_fitting();
+    return ok ? 0 : 1;
+}
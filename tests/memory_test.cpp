@@ -0,0 +1,194 @@
+#include "memory.hpp"
+#include "static_cache.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+using namespace Cache;
+
+// Проверка страничной памяти: чтение любого адреса возвращает данные режима
+// инициализации, страница заводится только записью, записанное читается обратно;
+// образы файлов читаются по своим адресам, а записи в них не доходят до файла;
+// отчёт об изменениях выводит только новые блоки и по возрастанию адреса
+namespace {
+    std::string captured(const std::function<void()>& action) {
+        std::ostringstream text;
+        auto* old = std::cout.rdbuf(text.rdbuf());
+        action();
+        standard_report()->flush();
+        std::cout.rdbuf(old);
+        return text.str();
+    }
+
+    constexpr uint64_t FAR = 0x7fff12345000ULL; // далеко за пределами прежних 0..0x1000
+
+    Data read(MemoryModel& memory, uint64_t address, size_t size) {
+        OutQuery result = memory.query(InQuery{Operation::READ, address, Data{}, size});
+        return result.returned_data ? *result.returned_data : Data{};
+    }
+
+    bool check_virtual_pages() {
+        bool ok = true;
+        MemoryModel zeros;
+        zeros.initialize(MemoryInitMode::ZEROS);
+        Data block = read(zeros, FAR + 0x40, 64);
+        ok &= block.valid_count == Data::SIZE && block[0] == 0 && block[15] == 0;
+
+        MemoryModel addresses;
+        addresses.initialize(MemoryInitMode::ADDRESSES);
+        block = read(addresses, FAR + 0x48, 8);
+        ok &= block.valid_count == 2 && block[0] == static_cast<int>(FAR + 0x48) &&
+              block[1] == static_cast<int>(FAR + 0x4c);
+        ok &= zeros.allocated_pages() == 0 && addresses.allocated_pages() == 0;
+
+        // Запись заводит одну страницу; остальная страница сохраняет виртуальные значения
+        Data value;
+        value[0] = -7;
+        value.valid_count = 1;
+        addresses.query(InQuery{Operation::WRITE, FAR + 0x84, value, 4});
+        ok &= addresses.allocated_pages() == 1;
+        block = read(addresses, FAR + 0x80, 64);
+        ok &= block[0] == static_cast<int>(FAR + 0x80) && block[1] == -7 && block[2] == static_cast<int>(FAR + 0x88);
+        block = read(addresses, FAR + 0xff0, 4);
+        ok &= block[0] == static_cast<int>(FAR + 0xff0);
+
+        // Соседние страницы и страницы в другом конце адресного пространства независимы
+        addresses.query(InQuery{Operation::WRITE, FAR + PAGE_SIZE, value, 4});
+        addresses.query(InQuery{Operation::WRITE, 0xfffffffffffff000ULL, value, 4});
+        addresses.query(InQuery{Operation::WRITE, FAR + 0x8, value, 4});
+        ok &= addresses.allocated_pages() == 3 && read(addresses, 0xfffffffffffff000ULL, 4)[0] == -7 &&
+              read(addresses, FAR + 0x84, 4)[0] == -7 && read(addresses, FAR + 0x8, 4)[0] == -7;
+
+        std::cout << "virtual pages: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Через иерархию: блоки далеко от нуля подкачиваются из виртуальных страниц,
+    // изменяются попаданием записи, вытесняются в память и читаются обратно
+    bool check_hierarchy() {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        std::vector<std::shared_ptr<Cache::Cache>> caches{
+            make_cache(1024, 64, 2, 48, WritePolicy::WRITE_BACK, AllocationPolicy::READ_ALLOCATE, ReplacementPolicy::LRU)};
+        MemoryHierarchy hierarchy(caches, memory);
+
+        bool ok = true;
+        for (uint64_t i = 0; i < 256; ++i) {
+            uint64_t address = FAR + i * 4096 + 16;
+            Data value;
+            value[0] = static_cast<int>(i);
+            value.valid_count = 1;
+            hierarchy.query(InQuery{Operation::READ, address, Data{}, 4});
+            hierarchy.query(InQuery{Operation::WRITE, address, value, 4});
+        }
+        for (uint64_t i = 0; i < 256; ++i) {
+            OutQuery result = hierarchy.query(InQuery{Operation::READ, FAR + i * 4096 + 16, Data{}, 8});
+            ok &= result.returned_data && (*result.returned_data)[0] == static_cast<int>(i) &&
+                  (*result.returned_data)[1] == static_cast<int>(FAR + i * 4096 + 20);
+        }
+        ok &= memory->allocated_pages() > 0 && memory->allocated_pages() <= 256;
+        std::cout << "hierarchy: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check_images() {
+        constexpr uint64_t BASE = 0x10000000;
+        constexpr size_t WORDS = 3 * PAGE_WORDS + 25; // хвост последней страницы - за концом файла
+        std::string path = "memory_test_image.bin";
+        {
+            std::ofstream out(path, std::ios::binary);
+            for (size_t i = 0; i < WORDS; ++i) {
+                int word = static_cast<int>(1000 + i);
+                out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+            }
+        }
+
+        bool ok = true;
+        MemoryModel memory;
+        memory.initialize(MemoryInitMode::ADDRESSES);
+        memory.map_image(path, BASE);
+        ok &= read(memory, BASE, 4)[0] == 1000 && read(memory, BASE + 4 * (WORDS - 1), 4)[0] == 1000 + WORDS - 1;
+        ok &= read(memory, BASE + 4 * WORDS, 4)[0] == 0;                       // за концом файла в той же странице
+        ok &= read(memory, BASE + 4 * PAGE_SIZE, 4)[0] == static_cast<int>(BASE + 4 * PAGE_SIZE); // после образа
+        ok &= read(memory, BASE - 4, 4)[0] == static_cast<int>(BASE - 4);
+
+        Data value;
+        value[0] = -1;
+        value.valid_count = 1;
+        memory.query(InQuery{Operation::WRITE, BASE + PAGE_SIZE + 8, value, 4});
+        memory.query(InQuery{Operation::WRITE, BASE + PAGE_SIZE + 72, value, 4});
+        ok &= read(memory, BASE + PAGE_SIZE + 8, 4)[0] == -1 && memory.allocated_pages() == 0;
+        ok &= captured([&] { memory.print_images(); }).find("1 of 4 pages modified") != std::string::npos;
+        ok &= captured([&] { memory.print_modified_memory(); }).find("0x10001000 | 2024, 2025, -1") != std::string::npos;
+
+        // Файл не изменился
+        std::ifstream in(path, std::ios::binary);
+        in.seekg(PAGE_SIZE + 8);
+        int word = 0;
+        in.read(reinterpret_cast<char*>(&word), sizeof(word));
+        ok &= word == static_cast<int>(1000 + PAGE_WORDS + 2);
+
+        auto throws = [&](uint64_t base) {
+            try {
+                memory.map_image(path, base);
+            } catch (const std::invalid_argument&) {
+                return true;
+            }
+            return false;
+        };
+        ok &= throws(BASE + 2 * PAGE_SIZE) && throws(BASE - PAGE_SIZE) && throws(BASE + 100);
+        MemoryImageSpec spec = parse_memory_image("dir/a@b.bin@0x7f0000001000");
+        ok &= spec.path == "dir/a@b.bin" && spec.base == 0x7f0000001000ULL;
+        std::remove(path.c_str());
+
+        std::cout << "images: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check_changes() {
+        MemoryModel memory;
+        memory.initialize(MemoryInitMode::ZEROS);
+        auto write = [&](uint64_t address, int word) {
+            Data value;
+            value[0] = word;
+            value.valid_count = 1;
+            memory.query(InQuery{Operation::WRITE, address, value, 4});
+        };
+        auto changes = [&] { return captured([&] { memory.print_memory_changes(); }); };
+
+        write(FAR + 0x2040, 3);
+        write(FAR, 1);
+        write(FAR + 0x2040, 4);
+        write(0x100, 2);
+        std::string first = changes();
+        size_t low = first.find("0x00000100 | 2, 0");
+        size_t middle = first.find("0x7fff12345000 | 1, 0");
+        size_t high = first.find("0x7fff12347040 | 4, 0");
+        bool ok = low != std::string::npos && middle != std::string::npos && high != std::string::npos &&
+                  low < middle && middle < high;
+        ok &= changes().empty();
+
+        write(FAR + 0x44, 5);
+        std::string second = changes();
+        ok &= second.find("0x7fff12345040 | 0, 5") != std::string::npos &&
+              second.find("0x7fff12345000") == std::string::npos && second.find("0x00000100") == std::string::npos;
+
+        // Полный список записанных блоков не зависит от отчётов
+        std::string all = captured([&] { memory.print_modified_memory(); });
+        ok &= all.find("0x00000100") < all.find("0x7fff12345000 | 1") &&
+              all.find("0x7fff12345000 | 1") < all.find("0x7fff12345040 | 0, 5") &&
+              all.find("0x7fff12345040") < all.find("0x7fff12347040 | 4");
+
+        std::cout << "changes: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main() {
+    bool ok = check_virtual_pages();
+    ok &= check_hierarchy();
+    ok &= check_images();
+    ok &= check_changes();
+    return ok ? 0 : 1;
+}
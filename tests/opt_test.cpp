@@ -0,0 +1,111 @@
+#include "opt.hpp"
+
+#include <algorithm>
+
+using namespace Cache;
+
+// Проверка OPT: таблица следующих обращений не зависит от размера куска и
+// совпадает с прямым поиском, промахи OptPolicy совпадают с наивным Belady и
+// не больше, чем у любой другой политики
+namespace {
+    AccessReaderFactory opener(const std::string& source) {
+        if (source.find(':') != std::string::npos) {
+            WorkloadSpec spec = parse_workload_spec(source);
+            return [spec] { return std::make_unique<AccessReader>(spec); };
+        }
+        return [source] { return std::make_unique<AccessReader>(source, TraceFormat::NATIVE); };
+    }
+
+    std::vector<SweepAccess> load(const AccessReaderFactory& open) {
+        std::vector<SweepAccess> trace;
+        auto reader = open();
+        SweepAccess access;
+        while (reader->next(access)) trace.push_back(access);
+        return trace;
+    }
+
+    bool check_table(const std::string& source, const std::vector<SweepAccess>& trace) {
+        bool ok = true;
+        for (size_t chunk : {size_t{1}, size_t{7}, NextUseTable::DEFAULT_CHUNK}) {
+            auto reader = opener(source)();
+            NextUseTable table(*reader, 64, chunk);
+            ok &= table.size() == trace.size();
+            for (size_t i = 0; ok && i < trace.size(); ++i) {
+                uint64_t expected = OptPolicy::NEVER;
+                for (size_t j = i + 1; j < trace.size(); ++j) {
+                    if (trace[j].address >> 6 == trace[i].address >> 6) {
+                        expected = j;
+                        break;
+                    }
+                }
+                ok = table.next() == expected;
+            }
+        }
+        std::cout << source << ": next-use table " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Belady в лоб: при вытеснении для каждого блока набора ищется следующее обращение
+    uint64_t naive_opt_misses(const std::vector<SweepAccess>& trace, size_t sets, size_t ways) {
+        std::vector<std::vector<uint64_t>> resident(sets);
+        uint64_t misses = 0;
+        for (size_t i = 0; i < trace.size(); ++i) {
+            uint64_t block = trace[i].address >> 6;
+            auto& set = resident[block % sets];
+            if (std::find(set.begin(), set.end(), block) != set.end()) continue;
+            ++misses;
+            if (set.size() == ways) {
+                auto next_use = [&](uint64_t candidate) {
+                    for (size_t j = i + 1; j < trace.size(); ++j) {
+                        if (trace[j].address >> 6 == candidate) return j;
+                    }
+                    return trace.size();
+                };
+                auto victim = std::max_element(set.begin(), set.end(), [&](uint64_t a, uint64_t b) {
+                    return next_use(a) < next_use(b);
+                });
+                set.erase(victim);
+            }
+            set.push_back(block);
+        }
+        return misses;
+    }
+
+    bool check_opt(const std::string& source, const std::vector<SweepAccess>& trace) {
+        bool ok = true;
+        for (size_t sets : {1, 4, 16}) {
+            for (size_t ways : {1, 2, 4, 8}) {
+                OptConfig config{sets * ways * 64, 64, ways, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, 32, 5};
+                auto results = compare_with_opt(config, opener(source));
+                uint64_t opt = results.front().stats.misses();
+                ok &= results.front().policy == ReplacementPolicy::OPT &&
+                      opt == naive_opt_misses(trace, sets, ways);
+                for (const auto& result : results) {
+                    ok &= result.stats.accesses() == trace.size() && result.stats.misses() >= opt;
+                    for (size_t set = 0; set < sets; ++set) {
+                        ok &= result.stats.set_accesses[set] == results.front().stats.set_accesses[set];
+                    }
+                }
+                if (!ok) {
+                    std::cout << source << ": " << sets << " sets x " << ways << " ways FAILED\n";
+                    return false;
+                }
+            }
+        }
+        std::cout << source << ": OPT OK\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> sources(argv + 1, argv + argc);
+    sources.push_back("zipf:footprint=16K:count=3K:alpha=0.8");
+    sources.push_back("mixed:footprint=8K:count=3K");
+    bool ok = true;
+    for (const auto& source : sources) {
+        auto trace = load(opener(source));
+        ok &= check_table(source, trace);
+        ok &= check_opt(source, trace);
+    }
+    return ok ? 0 : 1;
+}
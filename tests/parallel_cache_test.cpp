@@ -0,0 +1,130 @@
+#include "parallel_cache.hpp"
+#include "static_cache.hpp"
+#include "trace.hpp"
+#include "workload.hpp"
+
+#include <fstream>
+
+using namespace Cache;
+
+// Проверка SetPartitionedCache: на трассах из tests и на сгенерированных
+// ответы на каждое обращение, счётчики (в том числе по наборам) и обращения к памяти
+// совпадают с MemoryHierarchy из одного Cache
+namespace {
+    struct Setup {
+        const char* name;
+        size_t size;
+        uint64_t block_size;
+        size_t associativity;
+        WritePolicy wp;
+        AllocationPolicy ap;
+        ReplacementPolicy rp;
+    };
+
+    const Setup SETUPS[] = {
+        {"64kb_4way_lru_wb", 64 * 1024, 64, 4, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::LRU},
+        {"16kb_8way_plru_wt", 16 * 1024, 32, 8, WritePolicy::WRITE_THROUGH, AllocationPolicy::WRITE_ALLOCATE, ReplacementPolicy::PLRU},
+        {"256kb_16way_srrip", 256 * 1024, 64, 16, WritePolicy::WRITE_BACK, AllocationPolicy::READ_ALLOCATE, ReplacementPolicy::SRRIP},
+        {"8kb_2way_nru", 8 * 1024, 64, 2, WritePolicy::WRITE_BACK, AllocationPolicy::READ_ALLOCATE, ReplacementPolicy::NRU},
+        {"4kb_4way_mru", 4 * 1024, 64, 4, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::MRU},
+        {"32kb_4way_random", 32 * 1024, 64, 4, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::RANDOM},
+    };
+
+    std::vector<InQuery> load_text(const std::string& path) {
+        std::ifstream in(path);
+        std::vector<InQuery> queries;
+        TraceRecord record;
+        std::string line, error;
+        while (std::getline(in, line)) {
+            if (parse_trace_line(line, record, error) &&
+                (record.command == TraceCommand::LOAD || record.command == TraceCommand::STORE)) {
+                queries.push_back(record.query);
+            }
+        }
+        return queries;
+    }
+
+    std::vector<InQuery> generate(const std::string& text) {
+        WorkloadSpec spec = parse_workload_spec(text);
+        WorkloadGenerator generator(spec);
+        std::vector<InQuery> queries(spec.count);
+        for (auto& query : queries) generator.next(query);
+        return queries;
+    }
+
+    bool same_data(const std::optional<Data>& a, const std::optional<Data>& b) {
+        if (a.has_value() != b.has_value()) return false;
+        if (!a) return true;
+        return a->valid_count == b->valid_count && a->buffer == b->buffer;
+    }
+
+    bool same_result(const OutQuery& a, const OutQuery& b) {
+        if (a.hit != b.hit || a.evicted != b.evicted || a.evicted_tag != b.evicted_tag ||
+            a.fill_way != b.fill_way || a.out.size() != b.out.size() || !same_data(a.returned_data, b.returned_data)) {
+            return false;
+        }
+        for (size_t i = 0; i < a.out.size(); ++i) {
+            const InQuery& x = a.out[i];
+            const InQuery& y = b.out[i];
+            if (x.operation != y.operation || x.address != y.address || x.size != y.size ||
+                x.data.valid_count != y.data.valid_count || x.data.buffer != y.data.buffer) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool same_stats(const CacheStats& a, const CacheStats& b) {
+        return a.reads == b.reads && a.writes == b.writes && a.read_hits == b.read_hits &&
+               a.write_hits == b.write_hits && a.fills == b.fills && a.evictions == b.evictions &&
+               a.dirty_writebacks == b.dirty_writebacks && a.write_throughs == b.write_throughs &&
+               a.bypasses == b.bypasses && a.set_accesses == b.set_accesses && a.set_misses == b.set_misses;
+    }
+
+    // Пакеты разного размера: состояние шардов переходит из пакета в пакет
+    bool check(const std::string& name, const Setup& s, const std::vector<InQuery>& queries, DataMode mode) {
+        auto cache = std::make_shared<Cache::Cache>(s.size, s.block_size, s.associativity, 48, s.wp, s.ap, s.rp);
+        MemoryHierarchy serial({cache}, std::make_shared<MemoryModel>(), TraceLevel::NONE, mode);
+        SetPartitionedCache parallel(s.size, s.block_size, s.associativity, 48, s.wp, s.ap, s.rp,
+                                     InsertionPolicy::NORMAL, 4);
+        parallel.set_data_mode(mode);
+
+        std::vector<OutQuery> expected(queries.size());
+        std::vector<OutQuery> actual(queries.size());
+        serial.query_batch(queries.data(), queries.size(), expected.data());
+        for (size_t first = 0, batch = 1; first < queries.size(); first += batch, batch *= 4) {
+            batch = std::min(batch, queries.size() - first);
+            parallel.query_batch(queries.data() + first, batch, actual.data() + first);
+        }
+
+        bool ok = true;
+        for (size_t i = 0; ok && i < queries.size(); ++i) {
+            if (!same_result(expected[i], actual[i])) {
+                std::cout << name << " " << s.name << ": access " << i << " differs\n";
+                ok = false;
+            }
+        }
+        ok &= same_stats(cache->get_stats(), parallel.get_stats());
+        ok &= serial.get_memory_stats().reads == parallel.get_memory_stats().reads &&
+              serial.get_memory_stats().writes == parallel.get_memory_stats().writes;
+        std::cout << name << " " << s.name << (mode == DataMode::FULL ? "" : " tags-only") << ", "
+                  << parallel.shards() << " shards: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::pair<std::string, std::vector<InQuery>>> traces;
+    for (int i = 1; i < argc; ++i) traces.emplace_back(argv[i], load_text(argv[i]));
+    traces.emplace_back("mixed", generate("mixed:footprint=4M:count=200K:size=8"));
+    traces.emplace_back("zipf", generate("zipf:footprint=16M:count=200K:reads=0.6"));
+
+    bool ok = true;
+    for (const auto& [name, queries] : traces) {
+        for (const auto& setup : SETUPS) {
+            ok &= check(name, setup, queries, DataMode::FULL);
+            ok &= check(name, setup, queries, DataMode::TAGS_ONLY);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+#include "memory.hpp"
+#include "static_cache.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+
+using namespace Cache;
+
+// Проверка вывода событий: текст совпадает с прежним форматом, CSV и JSON дают
+// по событию на строку, NONE оставляет только статистику, а до flush ничего не
+// уходит в поток. Проверки вывода иерархии требуют CACHE_TRACE_LEVEL=2, события,
+// записанные в ReportSink напрямую, и статистика проверяются на любом уровне
+namespace {
+    const char* const TRACE[] = {"st 8 0x10 1 2", "ld 64 0x10", "ld 32 0x2010", "ld 32 0x4010", "st 4 0x2010 7"};
+
+    std::shared_ptr<MemoryHierarchy> make_hierarchy(std::ostream& out, OutputFormat format) {
+        auto memory = std::make_shared<MemoryModel>(TraceLevel::FULL);
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        memory->set_report(std::make_shared<ReportSink>(out, format));
+        std::vector<std::shared_ptr<Cache::Cache>> caches{
+            make_cache(128, 32, 2, 32, WritePolicy::WRITE_BACK, AllocationPolicy::BOTH, ReplacementPolicy::LRU)};
+        return std::make_shared<MemoryHierarchy>(caches, memory, TraceLevel::FULL);
+    }
+
+    void run(MemoryHierarchy& hierarchy) {
+        TraceRecord record;
+        std::string error;
+        for (std::string_view line : TRACE) {
+            parse_trace_line(line, record, error);
+            run_text_record(hierarchy, record.command, record.query, line);
+        }
+    }
+
+    std::vector<std::string> lines(const std::string& text) {
+        std::vector<std::string> result;
+        std::istringstream in(text);
+        for (std::string line; std::getline(in, line);) {
+            if (!line.empty()) result.push_back(line);
+        }
+        return result;
+    }
+
+    bool contains(const std::string& text, const std::string& part) {
+        return text.find(part) != std::string::npos;
+    }
+
+    bool check_text() {
+        std::ostringstream out;
+        auto hierarchy = make_hierarchy(out, OutputFormat::TEXT);
+        run(*hierarchy);
+        bool ok = out.str().empty(); // всё ещё в буфере
+        hierarchy->report().flush();
+        std::string text = out.str();
+        ok &= contains(text, "\nst 8 0x10 1 2\nL0: WRITE addr=0x10 size=8 - MISS\n"
+                             "MEM: READ addr=0x0 size_bits=32 (8 elements)\n");
+        ok &= contains(text, "L0: READ addr=0x10 size=64 - HIT data=[1, 2, 24, 28, 0, 0, 0, 0, 0, 0, 0, 0]\nData: 1 2 \n");
+        ok &= contains(text, "MEM: READ addr=0x4000 size_bits=32 (8 elements)\n");
+        ok &= contains(text, "L0: READ addr=0x4010 size=32 - MISS evicted=0x0\n");
+        ok &= contains(text, "\nModified Memory Contents\nAddress | Data\n0x00000000 | 0, 4, 8, 12, 1, 2, 24");
+        std::cout << "text: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check_csv() {
+        std::ostringstream out;
+        auto hierarchy = make_hierarchy(out, OutputFormat::CSV);
+        run(*hierarchy);
+        hierarchy->print_caches_state();
+        hierarchy->print_stats(true);
+
+        bool ok = true;
+        size_t accesses = 0;
+        for (const auto& line : lines(out.str())) {
+            std::string event = line.substr(0, line.find(','));
+            ok &= event == "command" || event == "access" || event == "mem" || event == "data" ||
+                  event == "block" || event == "cache_block" || event == "stats" || event == "memory_stats";
+            if (event == "access") {
+                ++accesses;
+                ok &= std::count(line.begin(), line.end(), ',') == 7;
+            }
+        }
+        std::string text = out.str();
+        ok &= accesses == std::size(TRACE);
+        ok &= contains(text, "command,\"ld 64 0x10\"\naccess,0,read,0x10,64,hit,,1 2 24 28 0 0 0 0 0 0 0 0\ndata,1 2\n");
+        ok &= contains(text, "access,0,read,0x4010,32,miss,0x0,\nmem,write,0x0,32,8,0 4 8 12 1 2 24 28\n");
+        ok &= contains(text, "cache_block,0,0,1,0x80,0x2000,dirty,8192 8196 8200 8204 7 8212 8216 8220\n");
+        ok &= contains(text, "stats,L0,5,2,3,3,1,2,1,3,1,1,0,0\n");
+        ok &= !contains(text, "Statistics");
+        std::cout << "csv: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check_json() {
+        std::ostringstream out;
+        auto hierarchy = make_hierarchy(out, OutputFormat::JSON);
+        run(*hierarchy);
+        hierarchy->print_caches_state();
+        hierarchy->print_stats();
+
+        bool ok = true;
+        for (const auto& line : lines(out.str())) {
+            ok &= line.rfind("{\"event\":\"", 0) == 0 && line.back() == '}';
+        }
+        std::string text = out.str();
+        ok &= contains(text, "{\"event\":\"access\",\"level\":0,\"op\":\"read\",\"address\":\"0x10\",\"size\":64,"
+                             "\"hit\":true,\"data\":[1,2,24,28,0,0,0,0,0,0,0,0]}\n");
+        ok &= contains(text, "{\"event\":\"cache_block\",\"level\":0,\"set\":0,\"way\":0,");
+        ok &= contains(text, "{\"event\":\"memory_stats\",\"reads\":");
+        std::cout << "json: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check_none() {
+        std::ostringstream out;
+        auto hierarchy = make_hierarchy(out, OutputFormat::NONE);
+        run(*hierarchy);
+        hierarchy->print_caches_state();
+        bool ok = out.str().empty();
+        hierarchy->print_stats();
+        ok &= out.str().rfind("\nStatistics\nL0: accesses=5", 0) == 0;
+        std::cout << "none: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Событие обращения с 64-битным вытесненным тегом, записанное в ReportSink напрямую
+    bool check_sink_access(const std::string& name, OutputFormat format, const std::string& expected) {
+        std::ostringstream out;
+        ReportSink sink(out, format);
+        OutQuery result;
+        result.evicted = true;
+        result.evicted_tag = 0x400000000;
+        sink.access(0, InQuery{Operation::READ, 0x1000, Data{}, 4}, result, true);
+        bool ok = out.str().empty(); // всё ещё в буфере
+        sink.flush();
+        ok &= contains(out.str(), expected);
+        std::cout << name << " sink access: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Пятый блок набора 0 model1 вытесняет первый: тег 0x400000000 не помещается в 32 бита
+    bool check_wide_tag(const std::string& name, OutputFormat format, const std::string& expected) {
+        std::ostringstream out;
+        auto memory = std::make_shared<MemoryModel>(TraceLevel::FULL);
+        memory->set_report(std::make_shared<ReportSink>(out, format));
+        auto hierarchy = make_model1_hierarchy(memory, TraceLevel::FULL);
+        for (uint64_t i = 1; i <= 5; ++i) {
+            hierarchy->query(InQuery{Operation::READ, i << 44, Data{}, 4});
+        }
+        hierarchy->report().flush();
+        bool ok = contains(out.str(), expected);
+        std::cout << name << " wide tag: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main() {
+    bool ok = check_sink_access("text", OutputFormat::TEXT, "L0: READ addr=0x1000 size=4 - MISS evicted=0x400000000\n");
+    ok &= check_sink_access("csv", OutputFormat::CSV, "access,0,read,0x1000,4,miss,0x400000000,");
+    ok &= check_sink_access("json", OutputFormat::JSON, "\"evicted_tag\":\"0x400000000\"");
+    ok &= check_none();
+    if constexpr (COMPILED_TRACE_LEVEL >= TraceLevel::FULL) {
+        ok &= check_text();
+        ok &= check_csv();
+        ok &= check_json();
+        ok &= check_wide_tag("text", OutputFormat::TEXT, "MISS evicted=0x400000000\n");
+        ok &= check_wide_tag("csv", OutputFormat::CSV, ",miss,0x400000000,");
+        ok &= check_wide_tag("json", OutputFormat::JSON, "\"evicted_tag\":\"0x400000000\"");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include "reuse.hpp"
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <list>
+#include <random>
+
+using namespace Cache;
+
+// Проверка анализатора стековых расстояний: расстояния совпадают с наивным
+// стеком LRU, а кривые промахов - со счётчиками Cache с LRU на каждой точке кривой
+namespace {
+    bool check_distances() {
+        StackDistanceCounter counter;
+        std::list<uint64_t> stack; // голова - последний блок
+        std::mt19937_64 rng(7);
+        bool ok = true;
+        // Больше обращений, чем начальный размер дерева, чтобы прошла перенумерация
+        for (size_t i = 0; ok && i < 20000; ++i) {
+            uint64_t block = rng() % (i % 3 ? 40 : 700);
+            auto it = std::find(stack.begin(), stack.end(), block);
+            uint64_t expected = StackDistanceCounter::COLD;
+            if (it != stack.end()) {
+                expected = std::distance(stack.begin(), it);
+                stack.erase(it);
+            }
+            stack.push_front(block);
+            ok = counter.access(block) == expected;
+        }
+        std::cout << "distances: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check_curves(const std::string& name, const std::vector<SweepAccess>& trace) {
+        const std::vector<size_t> set_counts{1, 4, 16, 64};
+        bool ok = true;
+        for (uint64_t block : {32, 64}) {
+            ReuseAnalyzer analyzer(block, set_counts);
+            for (const SweepAccess& access : trace) analyzer.access(access.address);
+            ok &= analyzer.accesses() == trace.size();
+
+            for (size_t sets : set_counts) {
+                for (size_t ways = 1; ways <= 8; ++ways) {
+                    SweepConfig config{sets * ways * block, block, ways, WritePolicy::WRITE_BACK,
+                                       AllocationPolicy::BOTH, ReplacementPolicy::LRU, 1, 0, 0};
+                    CacheStats stats = run_sweep_config(config, 32, trace).levels.front();
+                    uint64_t misses = stats.reads + stats.writes - stats.read_hits - stats.write_hits;
+                    if (analyzer.misses(sets, ways) != misses) {
+                        std::cout << name << ": block " << block << ", " << sets << " sets x " << ways
+                                  << " ways: " << analyzer.misses(sets, ways) << " != " << misses << "\n";
+                        ok = false;
+                    }
+                }
+            }
+        }
+        std::cout << name << ": " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool ok = check_distances();
+    for (int i = 1; i < argc; ++i) {
+        ok &= check_curves(argv[i], load_sweep_trace(argv[i], TraceFormat::NATIVE));
+    }
+    for (const char* spec : {"zipf:footprint=64K:count=30K:alpha=0.8", "mixed:footprint=32K:count=30K"}) {
+        ok &= check_curves(spec, load_sweep_trace(parse_workload_spec(spec)));
+    }
+    return ok ? 0 : 1;
+}
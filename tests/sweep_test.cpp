@@ -0,0 +1,119 @@
+#include "memory.hpp"
+#include "static_cache.hpp"
+#include "sweep.hpp"
+
+#include <functional>
+
+using namespace Cache;
+
+// Проверка перебора: сетка отбрасывает неподдерживаемые конфигурации, а
+// параллельный прогон (и по конфигурациям, и по наборам одной конфигурации) даёт
+// те же счётчики, что и run_tests на каждой конфигурации отдельно
+namespace {
+    std::string captured(const std::function<void()>& action) {
+        std::ostringstream text;
+        auto* old = std::cout.rdbuf(text.rdbuf());
+        action();
+        std::cout.rdbuf(old);
+        return text.str();
+    }
+
+    bool same_stats(const CacheStats& a, const CacheStats& b) {
+        return a.reads == b.reads && a.writes == b.writes && a.read_hits == b.read_hits &&
+               a.write_hits == b.write_hits && a.fills == b.fills && a.evictions == b.evictions &&
+               a.dirty_writebacks == b.dirty_writebacks && a.write_throughs == b.write_throughs &&
+               a.bypasses == b.bypasses;
+    }
+
+    bool check_grid() {
+        SweepGrid grid;
+        grid.sizes = {4096, 3000};
+        grid.associativities = {3, 4};
+        grid.replacements = {ReplacementPolicy::LRU, ReplacementPolicy::PLRU};
+        grid.levels = {1, 2};
+        grid.l2_sizes = {64 * 1024};
+        // 4096 / 64 / 3 - не целое; 3000 не делится; остаются 4096 x 4 x (LRU, PLRU) x (1, 2 уровня)
+        bool ok = grid.expand().size() == 4;
+        std::cout << "grid: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Каждая конфигурация заново через MemoryHierarchy и run_tests
+    bool check_against_run_tests(const std::string& path) {
+        SweepGrid grid;
+        grid.sizes = {256, 1024, 16 * 1024};
+        grid.block_sizes = {32, 64};
+        grid.associativities = {1, 4};
+        grid.write_policies = {WritePolicy::WRITE_BACK, WritePolicy::WRITE_THROUGH};
+        grid.alloc_policies = {AllocationPolicy::READ_ALLOCATE, AllocationPolicy::BOTH};
+        grid.replacements = {ReplacementPolicy::LRU, ReplacementPolicy::RANDOM, ReplacementPolicy::SRRIP};
+        grid.levels = {1, 2};
+        grid.l2_sizes = {4096};
+        grid.address_bits = 32;
+
+        auto configs = grid.expand();
+        auto trace = load_sweep_trace(path, TraceFormat::NATIVE);
+        auto results = run_sweep(configs, grid.address_bits, trace, 4);
+
+        bool ok = results.size() == configs.size();
+        for (size_t i = 0; ok && i < configs.size(); ++i) {
+            const SweepConfig& c = configs[i];
+            std::vector<std::shared_ptr<Cache::Cache>> caches{
+                make_cache(c.size, c.block_size, c.associativity, 32, c.write_policy, c.alloc_policy, c.replacement)};
+            if (c.levels > 1) {
+                caches.push_back(make_cache(c.l2_size, c.block_size, c.l2_associativity, 32,
+                                            c.write_policy, c.alloc_policy, c.replacement));
+            }
+            auto hierarchy = std::make_shared<MemoryHierarchy>(caches, std::make_shared<MemoryModel>(),
+                                                               TraceLevel::NONE, DataMode::TAGS_ONLY);
+            captured([&] { run_tests(path, hierarchy); });
+            for (size_t level = 0; level < c.levels; ++level) {
+                ok &= same_stats(results[i].levels[level], hierarchy->get_level_stats(level));
+            }
+            ok &= results[i].memory.reads == hierarchy->get_memory_stats().reads &&
+                  results[i].memory.writes == hierarchy->get_memory_stats().writes;
+
+            // Тот же прогон с наборами, поделёнными между потоками
+            SweepResult partitioned = run_sweep_config(c, grid.address_bits, trace, 4);
+            ok &= same_stats(partitioned.levels.front(), hierarchy->get_level_stats(0)) &&
+                  partitioned.memory.reads == hierarchy->get_memory_stats().reads &&
+                  partitioned.memory.writes == hierarchy->get_memory_stats().writes;
+            if (!ok) std::cout << path << ": configuration " << i << " differs\n";
+        }
+        std::cout << path << ": " << configs.size() << " configurations " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    // Один поток и много потоков дают одно и то же
+    bool check_threads() {
+        SweepGrid grid;
+        grid.sizes = {4096, 32 * 1024};
+        grid.associativities = {2, 8};
+        grid.replacements = {ReplacementPolicy::LRU, ReplacementPolicy::BRRIP, ReplacementPolicy::NRU};
+        grid.levels = {1, 2};
+        auto configs = grid.expand();
+        auto trace = load_sweep_trace(parse_workload_spec("mixed:footprint=256K:count=50K"));
+        auto serial = run_sweep(configs, grid.address_bits, trace, 1);
+        auto parallel = run_sweep(configs, grid.address_bits, trace, 8);
+
+        bool ok = serial.size() == parallel.size();
+        for (size_t i = 0; ok && i < serial.size(); ++i) {
+            for (size_t level = 0; level < serial[i].levels.size(); ++level) {
+                ok &= same_stats(serial[i].levels[level], parallel[i].levels[level]);
+            }
+            ok &= serial[i].memory.reads == parallel[i].memory.reads &&
+                  serial[i].memory.writes == parallel[i].memory.writes;
+        }
+        std::cout << "threads: " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool ok = check_grid();
+    for (int i = 1; i < argc; ++i) {
+        ok &= check_against_run_tests(argv[i]);
+    }
+    ok &= check_threads();
+    return ok ? 0 : 1;
+}
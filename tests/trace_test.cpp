@@ -0,0 +1,143 @@
+#include "memory.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+using namespace Cache;
+
+// Проверка двоичного формата: запись и чтение дают те же записи, а прогон
+// сконвертированной трассы через run_tests - то же состояние, что и текстовой
+namespace {
+    std::shared_ptr<MemoryHierarchy> make_model2() {
+        auto memory = std::make_shared<MemoryModel>();
+        memory->initialize(MemoryInitMode::ADDRESSES);
+        return make_model2_hierarchy(memory);
+    }
+
+    std::vector<TraceRecord> load_text(const std::string& path) {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            throw std::runtime_error("Cannot open trace: " + path);
+        }
+        std::vector<TraceRecord> records;
+        TraceRecord record;
+        std::string line, error;
+        while (std::getline(in, line)) {
+            if (parse_trace_line(line, record, error)) records.push_back(record);
+        }
+        return records;
+    }
+
+    // Адреса с большими скачками в обе стороны проверяют zigzag-varint
+    std::vector<TraceRecord> make_random(size_t count) {
+        std::vector<TraceRecord> records;
+        uint64_t seed = 99;
+        for (size_t i = 0; i < count; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            TraceRecord record;
+            record.command = (seed >> 60) < 8 ? TraceCommand::LOAD : TraceCommand::STORE;
+            uint64_t address = (i % 3 == 0) ? seed : (seed >> 40);
+            record.query = InQuery{record.command == TraceCommand::LOAD ? Operation::READ : Operation::WRITE,
+                                   address, {}, 4 * (1 + (seed >> 20) % Data::SIZE)};
+            if (record.command == TraceCommand::STORE) {
+                record.query.data.valid_count = record.query.size / sizeof(int);
+                for (size_t v = 0; v < record.query.data.valid_count; ++v) {
+                    record.query.data[v] = static_cast<int>(seed >> v);
+                }
+            }
+            records.push_back(record);
+        }
+        return records;
+    }
+
+    std::string encode(const std::vector<TraceRecord>& records) {
+        std::ostringstream out;
+        BinaryTraceWriter writer(out);
+        for (const auto& record : records) writer.write(record);
+        return out.str();
+    }
+
+    bool same_record(const TraceRecord& a, const TraceRecord& b) {
+        if (a.command != b.command) return false;
+        if (a.command == TraceCommand::SHOW || a.command == TraceCommand::STATS) return true;
+        if (a.query.operation != b.query.operation || a.query.address != b.query.address ||
+            a.query.size != b.query.size) return false;
+        if (a.command == TraceCommand::LOAD) return true;
+        if (a.query.data.valid_count != b.query.data.valid_count) return false;
+        for (size_t i = 0; i < a.query.data.valid_count; ++i) {
+            if (a.query.data[i] != b.query.data[i]) return false;
+        }
+        return true;
+    }
+
+    bool check_roundtrip(const std::string& name, const std::vector<TraceRecord>& records) {
+        std::string bytes = encode(records);
+        BinaryTraceReader reader(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+        TraceRecord decoded;
+        size_t i = 0;
+        for (; reader.next(decoded); ++i) {
+            if (i >= records.size() || !same_record(records[i], decoded)) {
+                std::cout << name << ": record " << i << " differs after decoding\n";
+                return false;
+            }
+        }
+        if (i != records.size()) {
+            std::cout << name << ": decoded " << i << " of " << records.size() << " records\n";
+            return false;
+        }
+        std::cout << name << ": " << records.size() << " records, " << bytes.size() << " bytes OK\n";
+        return true;
+    }
+
+    std::string captured(const std::function<void()>& action) {
+        std::ostringstream text;
+        auto* old = std::cout.rdbuf(text.rdbuf());
+        action();
+        std::cout.rdbuf(old);
+        return text.str();
+    }
+
+    // Итоговое состояние после текстовой трассы и после её двоичной копии совпадает
+    bool check_run(const std::string& path, const std::string& binary_path) {
+        auto records = load_text(path);
+        {
+            std::ofstream out(binary_path, std::ios::binary);
+            BinaryTraceWriter writer(out);
+            for (const auto& record : records) writer.write(record);
+        }
+
+        auto text = make_model2();
+        auto binary = make_model2();
+        std::string expected = captured([&] {
+            for (const auto& record : records) {
+                if (record.command == TraceCommand::LOAD || record.command == TraceCommand::STORE) {
+                    text->query(record.query);
+                }
+            }
+            text->print_caches_state();
+            text->print_stats(true);
+        });
+        captured([&] { run_tests(binary_path, binary); });
+        std::string actual_state = captured([&] {
+            binary->print_caches_state();
+            binary->print_stats(true);
+        });
+        std::remove(binary_path.c_str());
+
+        bool ok = actual_state == expected;
+        std::cout << path << ": binary run " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool ok = true;
+    for (int i = 1; i < argc; ++i) {
+        ok &= check_roundtrip(argv[i], load_text(argv[i]));
+        ok &= check_run(argv[i], "trace_test_" + std::to_string(i) + ".bin"); // в рабочем каталоге теста
+    }
+    ok &= check_roundtrip("random", make_random(100000));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "memory.hpp"
+#include "workload.hpp"
+
+#include <map>
+#include <set>
+
+using namespace Cache;
+
+// Проверка генераторов: разбор описания, адреса в пределах footprint,
+// воспроизводимость по seed, доля чтений, обход всего цикла chase и перекос zipf
+namespace {
+    std::vector<InQuery> generate(const std::string& text, size_t count) {
+        WorkloadGenerator generator(parse_workload_spec(text));
+        std::vector<InQuery> queries(count);
+        for (auto& query : queries) generator.next(query);
+        return queries;
+    }
+
+    bool report(const std::string& name, bool ok) {
+        std::cout << name << ": " << (ok ? "OK" : "FAILED") << "\n";
+        return ok;
+    }
+
+    bool check_parse() {
+        WorkloadSpec spec = parse_workload_spec("zipf:footprint=64M:alpha=0.9:count=2K:base=0x1000:reads=0.5");
+        bool ok = spec.pattern == WorkloadPattern::ZIPF && spec.footprint == 64ULL << 20 &&
+                  spec.alpha == 0.9 && spec.count == 2048 && spec.base == 0x1000 && spec.read_ratio == 0.5;
+        for (const char* bad : {"zigzag", "seq:footprint", "seq:size=1000", "uniform:reads=2", "seq:color=1",
+                                "seq:footprint=17179869184G", "seq:footprint=18014398509481985K"}) {
+            try {
+                parse_workload_spec(bad);
+                ok = false;
+            } catch (const std::invalid_argument&) {
+            }
+        }
+        return report("parse", ok);
+    }
+
+    bool check_bounds() {
+        bool ok = true;
+        for (const char* text : {"seq", "stride:stride=192", "uniform", "zipf", "chase", "mixed"}) {
+            std::string full = std::string(text) + ":footprint=64K:base=0x100000";
+            for (const auto& query : generate(full, 10000)) {
+                ok &= query.address >= 0x100000 && query.address + query.size <= 0x100000 + 64 * 1024;
+            }
+            ok &= report(std::string(text) + " bounds", ok);
+        }
+        return ok;
+    }
+
+    bool check_seed() {
+        auto a = generate("mixed:seed=5", 5000);
+        auto b = generate("mixed:seed=5", 5000);
+        auto c = generate("mixed:seed=6", 5000);
+        bool same = true, different = false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            same &= a[i].address == b[i].address && a[i].operation == b[i].operation;
+            different |= a[i].address != c[i].address;
+        }
+        return report("seed", same && different);
+    }
+
+    bool check_reads() {
+        size_t reads = 0;
+        auto queries = generate("uniform:reads=0.25", 100000);
+        for (const auto& query : queries) {
+            reads += query.operation == Operation::READ;
+            if (query.operation == Operation::WRITE && query.data.valid_count != 1) return report("reads", false);
+        }
+        return report("reads", reads > 23000 && reads < 27000);
+    }
+
+    // Цикл Саттоло проходит все строки ровно по разу
+    bool check_chase() {
+        auto queries = generate("chase:footprint=64K:stride=64", 1024);
+        std::set<uint64_t> lines;
+        for (const auto& query : queries) lines.insert(query.address / 64);
+        auto again = generate("chase:footprint=64K:stride=64", 1025);
+        return report("chase", lines.size() == 1024 && again[1024].address == again[0].address);
+    }
+
+    // Самая популярная строка при alpha = 1 и 1024 строках - около 1/H(1024) ~ 13% обращений
+    bool check_zipf() {
+        std::map<uint64_t, size_t> counts;
+        for (const auto& query : generate("zipf:footprint=64K:alpha=1", 100000)) ++counts[query.address];
+        size_t top = 0;
+        for (const auto& [address, count] : counts) top = std::max(top, count);
+        return report("zipf", top > 11000 && top < 15500 && counts.size() > 500);
+    }
+}
+
+int main() {
+    bool ok = true;
+    ok &= check_parse();
+    ok &= check_bounds();
+    ok &= check_seed();
+    ok &= check_reads();
+    ok &= check_chase();
+    ok &= check_zipf();
+    return ok ? 0 : 1;
+}